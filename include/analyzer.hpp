@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+#include "ast.hpp"
+#include "parser.hpp"
+#include "token_buffer.hpp"
+#include "type_table.hpp"
+
+namespace cntlang
+{
+	class semantic_error : public std::exception
+	{
+	public:
+		enum class kind
+		{
+			undeclared_identifier,
+			expected_bool,
+			expected_number,
+			expected_int,
+			incompatible_types,
+			not_callable,
+			wrong_argument_count,
+			not_assignable,
+			expected_variable,
+			immutable_reference,
+			missing_initializer,
+			missing_return_value,
+			unexpected_return_value,
+			ill_formed_type,
+			circular_type,
+			loop_control_outside_loop
+		};
+
+		explicit semantic_error(kind error, int line, int column) noexcept;
+		static const char* describe(kind error) noexcept;
+		const char* what() const noexcept override;
+		kind error() const noexcept;
+		int line() const noexcept;
+		int column() const noexcept;
+
+	private:
+		kind m_error;
+		int m_line;
+		int m_column;
+	};
+
+	struct semantic_diagnostic
+	{
+		typename semantic_error::kind error;
+		std::uint32_t offset;
+	};
+
+	// Types and resolves a parsed program. The globals are checked first, serially, which interns every
+	// signature a call can refer to; then each function body is checked on its own, on a work-stealing pool
+	// when threads > 1. A body a lazy parse left is parsed and checked once something checked names its
+	// function, so only those reached from the globals are; the others stay lazy and unchecked.
+	class analyzer
+	{
+	public:
+		analyzer(const ast& tree, const token_buffer& tokens, type_table& types, unsigned threads = 1);
+		analyzer(parser& source, type_table& types, unsigned threads = 1); // parses lazy bodies as they are reached, throwing parser_error
+
+		void analyze(); // throws the first error in source order
+		void analyze(std::vector<semantic_diagnostic>& diagnostics); // all of them, in source order
+		void analyze(std::vector<parser_diagnostic>& syntax, std::vector<semantic_diagnostic>& diagnostics); // and those of the lazy bodies it parses
+		std::uint32_t type(std::uint32_t node) const noexcept; // of an expression or declaration, type_table::invalid after an error
+
+	private:
+		struct arena // one per worker, reused from body to body
+		{
+			std::vector<semantic_diagnostic> diagnostics;
+			std::vector<std::uint32_t> scratch; // parameters of the signatures being worked out
+			std::vector<std::uint32_t> resolving; // declarations whose type is being worked out, to catch cycles
+			std::vector<std::uint32_t> deferred; // bodies naming a signature no one has interned yet
+			std::vector<std::uint32_t> reached; // function_definitions named by what was checked
+			std::uint32_t result = type_table::none; // of the function being checked
+			std::uint32_t loops = 0;
+			bool shared = false; // other workers read the type table, only look signatures up
+			bool missing = false; // a lookup failed, the body is checked again serially
+		};
+
+		static bool poisoned(std::uint32_t type) noexcept; // an error was reported for it already
+		static bool numeric(std::uint32_t type) noexcept;
+		static bool convertible(std::uint32_t from, std::uint32_t to) noexcept; // int widens to real
+
+		void report(typename semantic_error::kind error, std::uint32_t at, arena& local);
+		bool names_variable(std::uint32_t expression) const noexcept;
+
+		void check_globals(arena& local);
+		void parse_reached(arena& local, std::vector<std::uint32_t>& functions); // the lazy bodies local reached, which functions get
+		void check_function(std::uint32_t definition, arena& local);
+		void check_statements(std::uint32_t list, arena& local);
+		void check_statement(std::uint32_t statement, arena& local);
+		void check_initializer(std::uint32_t declaration, std::uint32_t value, arena& local);
+		void check_condition(std::uint32_t expression, arena& local);
+		void check_number(std::uint32_t expression, arena& local);
+		void check_binding(std::uint32_t reference, std::uint32_t value, arena& local); // of a & declaration to value
+
+		std::uint32_t declared(std::uint32_t declaration, arena& local); // of a declaration or function_definition
+		std::uint32_t annotation(std::uint32_t type, arena& local);
+		bool deduce(std::uint32_t type, arena& local); // the expressions of type! in it, false if one failed
+		std::uint32_t expression(std::uint32_t expression, arena& local);
+		std::uint32_t operation(std::uint32_t expression, arena& local); // binary
+		std::uint32_t call(std::uint32_t expression, arena& local);
+
+		parser* m_source = nullptr; // of the tree, when bodies may still be lazy
+		std::vector<parser_diagnostic>* m_syntax = nullptr; // their errors are recorded here instead of thrown
+		const ast& m_tree;
+		const token_buffer& m_tokens;
+		type_table& m_types;
+		unsigned m_threads;
+		std::vector<std::uint32_t> m_node_types; // per node; each body only writes its own nodes
+	};
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "node.hpp"
+#include "uninitialized_allocator.hpp"
+
+namespace cntlang
+{
+	// Owns every node of one compilation in a few flat arrays, so the whole tree is freed at once.
+	class ast
+	{
+	public:
+		static constexpr std::uint32_t dummy = 0; // shared placeholder for absent optional children
+
+		ast();
+
+		void reserve(std::size_t nodes);
+		void clear();
+
+		std::uint32_t add(typename node::kind type, std::uint32_t token); // leaf
+		std::uint32_t add(typename node::kind type, std::uint32_t token, const std::uint32_t* children, std::uint32_t count);
+		void set_children(std::uint32_t index, const std::uint32_t* children, std::uint32_t count); // of a node added as a leaf
+		void set_child(std::uint32_t index, std::uint32_t nth, std::uint32_t child) noexcept;
+		void shift_tokens(std::uint32_t first, std::uint32_t removed, std::uint32_t inserted) noexcept; // after a token_change
+		void replace(std::uint32_t index, std::uint32_t with) noexcept; // index takes over with's token and children
+		void rebind(std::uint32_t from, std::uint32_t to, std::uint32_t firstUse) noexcept;
+		std::uint32_t splice(const ast& other); // appends other's nodes; other's node i > 0 becomes the result + i
+		std::pair<std::uint32_t, std::uint32_t> grow(const ast& other); // room for other's nodes, left indeterminate; base and child base
+		void splice(const ast& other, std::pair<std::uint32_t, std::uint32_t> bases) noexcept; // into the room grow() made for it
+		std::vector<std::uint32_t> compact(); // drops what the root no longer reaches; the new index of each node, dummy if dropped
+		void set_root(std::uint32_t index) noexcept;
+		void bind(std::uint32_t use, std::uint32_t declaration) noexcept;
+
+		std::uint32_t root() const noexcept;
+		std::uint32_t size() const noexcept;
+		const node& operator[](std::uint32_t index) const noexcept;
+		std::uint32_t token(std::uint32_t index) const noexcept; // into the token buffer the tree was parsed from
+		const std::uint32_t* children(std::uint32_t index) const noexcept;
+		std::uint32_t child(std::uint32_t index, std::uint32_t nth) const noexcept;
+		std::uint32_t binding(std::uint32_t use) const noexcept; // declaring node of a name, dummy if unresolved
+
+	private:
+		std::vector<node, uninitialized_allocator<node>> m_nodes;
+		std::vector<std::uint32_t, uninitialized_allocator<std::uint32_t>> m_tokens; // per node, kept apart so an edit's shift streams over 4 bytes a node
+		std::vector<std::uint32_t, uninitialized_allocator<std::uint32_t>> m_children;
+		std::vector<std::uint32_t, uninitialized_allocator<std::uint32_t>> m_bindings; // per node
+		std::uint32_t m_root = dummy;
+	};
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "analyzer.hpp"
+#include "ast.hpp"
+#include "token.hpp"
+#include "token_buffer.hpp"
+
+namespace cntlang
+{
+	struct constant
+	{
+		std::uint32_t type; // type_table::boolean, integer, real or a function type; none if the node is not constant
+		literal_value value; // bool in integer, the function_definition node of a function
+	};
+
+	// Folds the operators over literals, immutable bindings with constant initializers, line! and column! of an
+	// analyzed program into a side table; an execution engine takes a constant node's value instead of walking it.
+	// Integer overflow and division by zero are left to run, so folding never changes what a program does;
+	// globals are initialized in source order, so an initializer only takes the values of the globals before it,
+	// and a function body those before the first initializer that calls anything.
+	class constant_folder
+	{
+	public:
+		constant_folder(const ast& tree, const token_buffer& tokens, const analyzer& types);
+
+		std::uint32_t fold(); // the number of nodes no longer walked
+		bool is_constant(std::uint32_t node) const noexcept;
+		const constant& value(std::uint32_t node) const noexcept;
+
+		static bool convert(constant& folded, std::uint32_t type) noexcept; // to the base of type, false if it is another
+		static bool evaluate(typename token::kind op, constant operand, constant& result) noexcept; // unary
+		static bool evaluate(typename token::kind op, constant left, constant right, constant& result) noexcept; // false where the operation is left to run
+
+	private:
+		enum class state : std::uint8_t { unvisited, visiting, done };
+
+		bool calls(std::uint32_t node) const noexcept; // anything, somewhere under node
+		void fold_node(std::uint32_t node); // statements and the expressions in them
+		void fold_definition(std::uint32_t definition);
+		bool fold_expression(std::uint32_t expression);
+		bool fold_name(std::uint32_t expression);
+		bool fold_unary(std::uint32_t expression);
+		bool fold_binary(std::uint32_t expression);
+		static bool arithmetic(typename token::kind op, std::int64_t left, std::int64_t right, std::int64_t& result) noexcept; // false on overflow and division by zero
+
+		const ast& m_tree;
+		const token_buffer& m_tokens;
+		const analyzer& m_types;
+		std::vector<constant> m_values; // per node
+		static constexpr std::uint32_t no_position = ~std::uint32_t(0);
+
+		std::vector<std::uint32_t> m_definitions; // variable_definition of each global declaration
+		std::vector<std::uint32_t> m_positions; // of each global declaration among the definitions
+		std::vector<state> m_states; // per declaration, globals are folded when first named
+		std::uint32_t m_initialized = no_position; // globals from this position on are not while folding an initializer
+		std::uint32_t m_first_call = no_position; // of the first global initializer making a call
+		std::uint32_t m_skipped = 0;
+	};
+}
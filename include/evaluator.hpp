@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "analyzer.hpp"
+#include "ast.hpp"
+#include "constant_folder.hpp"
+#include "token_buffer.hpp"
+#include "type_table.hpp"
+
+namespace cntlang
+{
+	struct globals_image
+	{
+		std::vector<std::uint32_t> declarations; // globals evaluated while compiling, in source order
+		std::vector<constant> values; // of each, converted to its declared type
+		std::vector<std::uint32_t> pending; // variable_definitions still initialized at startup, in source order
+	};
+
+	// Runs global initializers while compiling, calls to functions included, and keeps the values in a
+	// globals_image. An initializer is evaluated only when the outcome cannot differ from running it at
+	// startup: it may read earlier immutable globals that are in the image and the locals of the functions it
+	// calls, and must finish within the step budget. Mutable globals, references, for loops and variables
+	// left to default initialization are not evaluated, nor are and and or over a right operand that calls or
+	// assigns, since whether it runs is not pinned down yet; their initializers stay pending.
+	class evaluator
+	{
+	public:
+		static constexpr std::uint64_t default_steps = 1 << 20; // per initializer
+		static constexpr std::uint32_t max_depth = 512; // nested calls
+
+		evaluator(const ast& tree, const token_buffer& tokens, const analyzer& types, const type_table& table, const constant_folder& constants, std::uint64_t steps = default_steps);
+
+		globals_image evaluate();
+
+	private:
+		static constexpr std::uint32_t no_slot = ~std::uint32_t(0);
+
+		enum class outcome : std::uint8_t { next, broke, continued, returned, failed };
+		enum class effect : std::uint8_t { unknown, none, some };
+
+		std::uint32_t layout(std::uint32_t function); // slots of its parameters and locals, the size of its frame
+		void assign_slots(std::uint32_t statement, std::uint32_t& slots);
+
+		bool step() noexcept;
+		outcome execute(std::uint32_t statement);
+		outcome execute_list(std::uint32_t list);
+		outcome execute_while(std::uint32_t statement);
+		bool evaluate(std::uint32_t expression, constant& result);
+		bool effects(std::uint32_t expression); // a call or an assignment somewhere under expression
+		bool condition(std::uint32_t expression, bool& result);
+		bool read(std::uint32_t declaration, constant& result);
+		bool assign(std::uint32_t expression, constant& result);
+		bool call(std::uint32_t expression, constant& result);
+
+		const ast& m_tree;
+		const token_buffer& m_tokens;
+		const analyzer& m_types;
+		const type_table& m_table;
+		const constant_folder& m_constants;
+		std::uint64_t m_budget;
+		std::uint64_t m_steps = 0; // left for the current initializer
+		std::uint32_t m_depth = 0;
+		std::uint32_t m_current = 0; // position of the initializer among the definitions
+		std::uint32_t m_base = 0; // frame of the function running, in m_stack
+		constant m_result{ type_table::none, {} }; // of the last return
+		std::vector<constant> m_stack; // locals of the calls in progress, type_table::none until assigned
+		std::vector<constant> m_globals; // per declaration, none if not in the image
+		std::vector<std::uint32_t> m_order; // per global declaration, its position among the definitions
+		std::vector<std::uint32_t> m_slots; // per local declaration, its slot in the frame of its function
+		std::vector<std::uint32_t> m_frames; // per function_definition, the size of its frame once laid out
+		std::vector<effect> m_effects; // per expression, once worked out
+	};
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <string_view>
+
+namespace cntlang
+{
+	class interner
+	{
+	public:
+		interner(std::size_t expectedSymbols = 1024);
+
+		std::uint32_t intern(std::string_view name);
+		std::string_view name(std::uint32_t symbol) const noexcept;
+		std::uint32_t size() const noexcept;
+
+	private:
+		static std::uint32_t hash(std::string_view name) noexcept;
+		void grow();
+
+		std::vector<char> m_characters;
+		std::vector<std::uint32_t> m_offsets; // symbol i spans [m_offsets[i], m_offsets[i + 1])
+		std::vector<std::uint32_t> m_hashes;
+		std::vector<std::uint32_t> m_slots; // symbol + 1, 0 when empty
+	};
+}
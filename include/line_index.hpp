@@ -0,0 +1,32 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <string_view>
+
+namespace cntlang
+{
+	struct position
+	{
+		int line;
+		int column;
+	};
+
+	class line_index
+	{
+	public:
+		line_index();
+
+		void scan(const char* first, const char* last, std::size_t offset); // offset of *first
+		void append(std::size_t lineStart);
+		void append(const line_index& other, std::size_t offset); // other indexes a source starting at a line start, at offset
+		void edit(std::size_t offset, std::size_t removed, std::string_view inserted);
+		position locate(std::size_t offset) const noexcept;
+
+		std::size_t size() const noexcept;
+		std::size_t line_start(std::size_t line) const noexcept; // 1-based
+
+	private:
+		std::vector<std::size_t> m_starts;
+	};
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace cntlang
+{
+	class mapped_file
+	{
+	public:
+		explicit mapped_file(const std::string& path);
+		mapped_file(mapped_file&& other) noexcept;
+		mapped_file(const mapped_file&) = delete;
+		~mapped_file();
+
+		mapped_file& operator=(mapped_file&& other) noexcept;
+		mapped_file& operator=(const mapped_file&) = delete;
+
+		const char* data() const noexcept;
+		std::size_t size() const noexcept;
+		std::string_view contents() const noexcept;
+
+	private:
+		void unmap() noexcept;
+
+		const char* m_data = nullptr;
+		std::size_t m_size = 0;
+	};
+}
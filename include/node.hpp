@@ -1,17 +1,17 @@
 #pragma once
 
-#include <variant>
-#include "token.hpp"
+#include <cstdint>
 
 namespace cntlang
 {
+	// Flat AST node: children are the range [first, first + count) of the owning ast's child-index array;
+	// the node's token lives in a parallel array of the ast (see ast::token).
 	struct node
 	{
-		using tree_type = std::vector<node>;
-
-		enum class kind
+		enum class kind : std::uint8_t
 		{
 			dummy,
+			error, // stands in for what failed to parse
 
 			program,
 			variable_definition, function_definition,
@@ -24,27 +24,19 @@ namespace cntlang
 			unary_expression,
 			primary_expression,
 			call_expression,
-			intrinsic_expression
-		};
+			intrinsic_expression,
 
-		kind type;
-		std::variant<std::monostate, token, tree_type> data;
-
-		template<typename T>
-		node(kind type, T&& data)
-		: type(type)
-		, data(std::move(data))
-		{
-		}
+			terminal,
+			declaration, declaration_list,
+			statement_list, lazy_body,
+			type, function_type
+		};
 
-		void append(node&& child)
-		{
-			std::get<tree_type>(data).emplace_back(std::move(child));
-		}
+		static constexpr std::uint32_t no_token = ~std::uint32_t(0);
+		static constexpr std::uint32_t stale_token = no_token - 1; // removed by an edit
 
-		void append_dummy()
-		{
-			std::get<tree_type>(data).emplace_back(node(kind::dummy, std::monostate()));
-		}
+		kind type;
+		std::uint32_t first;
+		std::uint32_t count;
 	};
 }
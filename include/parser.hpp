@@ -1,8 +1,15 @@
 #pragma once
 
-#include <unordered_map>
+#include <cstdint>
+#include <utility>
 #include <stdexcept>
+#include <vector>
+#include "ast.hpp"
+#include "interner.hpp"
 #include "stream_info.hpp"
+#include "symbol_table.hpp"
+#include "token_buffer.hpp"
+#include "token_pipeline.hpp"
 #include "node.hpp"
 
 namespace cntlang
@@ -13,10 +20,25 @@ namespace cntlang
 		enum class kind
 		{
 			global_expected,
-			/* to-do */
+			expected_identifier,
+			expected_type,
+			expected_expression,
+			expected_colon,
+			expected_semicolon,
+			expected_delimiter,
+			expected_assign,
+			expected_parenthesis_left,
+			expected_parenthesis_right,
+			expected_let,
+			expected_then,
+			expected_do,
+			expected_end,
+			duplicate_declaration
 		};
 
 		explicit parser_error(kind error, int line, int column) noexcept;
+		static const char* describe(kind error) noexcept;
+		const char* what() const noexcept override;
 		kind error() const noexcept;
 		int line() const noexcept;
 		int column() const noexcept;
@@ -27,20 +49,115 @@ namespace cntlang
 		int m_column;
 	};
 
+	struct parser_diagnostic
+	{
+		typename parser_error::kind error;
+		std::uint32_t offset;
+	};
+
 	class parser
 	{
 	public:
-		explicit parser(stream_info& stream);
+		parser(stream_info& stream, interner& symbols);
+		parser(const token_buffer& tokens, interner& symbols, unsigned threads = 1); // walks a pre-lexed buffer by index
+		parser(token_pipeline& pipeline, interner& symbols); // consumes tokens lexed on another thread
 
-		const node& parse();
+		const ast& parse(bool lazy = false); // lazy leaves function bodies as lazy_body until parse_body
+		const ast& parse(std::vector<parser_diagnostic>& diagnostics, bool lazy = false); // recovers, error nodes mark what failed
+		const ast& parse_generated(); // walks the LL(1) tables built from doc/parser_rules.ebnf, same tree as parse()
+		std::uint32_t parse_body(std::uint32_t definition); // statement_list of a function_definition
+		std::uint32_t parse_body(std::uint32_t definition, std::vector<parser_diagnostic>& diagnostics); // recovers, diagnostics stay in source order
+		void parse_bodies(); // every body parse() left lazy, so the tree is the one an eager parse builds
+		void parse_bodies(std::vector<parser_diagnostic>& diagnostics); // recovers, diagnostics stay in source order
+		std::uint32_t reparse(const token_change& change); // after relex() edited the buffer; returns the replaced node, other indices may move
+		const ast& tree() const noexcept;
+		const token_buffer& tokens() const noexcept; // the buffer node tokens index into
 
 	private:
-		using declaration_list = std::unordered_map<std::string, const node* const>;
+		static constexpr std::uint32_t min_group_tokens = 1 << 15; // per thread when parsing in parallel
+
+		struct frame // a lowercase rule of the generated grammar being parsed
+		{
+			std::uint8_t rule;
+			std::uint32_t start; // its first token
+			std::uint32_t token; // of the node it builds, if not start
+			std::uint32_t node; // added before its children
+			std::uint32_t mark; // its children are pending from here
+		};
+
+		parser(const token_buffer& tokens, interner& symbols, std::uint32_t first, std::uint32_t last); // one group of definitions
+
+		void keep_scanned();
+		void scan();
+		void expect(typename token::kind kind, typename parser_error::kind error);
+		void consume(typename token::kind kind, typename parser_error::kind error);
+		void fail(typename parser_error::kind error); // at the current token, then resynchronize
+		void error_token(); // the current token, which the lexer reported
+		void report(typename parser_error::kind error, std::uint32_t offset);
+		[[noreturn]] void raise(typename parser_error::kind error, std::uint32_t offset);
+		void synchronize();
+		void synchronize_definitions();
+		void skip_block();
+		std::uint32_t abandon(std::uint32_t keyword, std::size_t mark);
+		std::uint32_t leaf(typename node::kind type);
+		std::uint32_t close(typename node::kind type, std::uint32_t token, std::size_t mark); // children pending since mark
+		void close(std::uint32_t index, std::size_t mark);
+		void declare(std::uint32_t declaration); // named by the node's token
+		void resolve(std::uint32_t use, std::uint32_t name);
+
+		std::uint32_t parse_program();
+		std::uint32_t parse_program_parallel();
+		void parse_definitions();
+		void declare_definition(std::uint32_t definition);
+		void resolve_globals();
+		std::uint32_t parse_again();
+		std::uint32_t collect(std::uint32_t kept); // compacts the tree once reparses orphaned enough of it; kept's new index
+		std::uint32_t reparse_definition(std::uint32_t definition, std::uint32_t last);
+		std::uint32_t reparse_list(const token_change& change, std::uint32_t definition, std::uint32_t terminator);
+		std::uint32_t statement_start(std::uint32_t statement) const noexcept;
+		std::uint32_t definition_start(std::uint32_t definition) const noexcept;
+		std::uint32_t last_before(std::uint32_t index) const noexcept; // last token before index that is not a comment
+		std::uint32_t parse_variable_definition();
+		std::uint32_t parse_function_definition();
+		std::uint32_t parse_statement_list();
+		std::uint32_t skip_statement_list();
+		std::uint32_t parse_statement();
+		std::uint32_t parse_return_statement();
+		std::uint32_t parse_if_statement();
+		std::uint32_t parse_while_statement();
+		std::uint32_t parse_for_statement();
+
+		std::uint32_t parse_expression(int precedence = 1);
+		std::uint32_t parse_unary_expression();
+		std::uint32_t parse_primary_expression();
+		std::uint32_t parse_call_expression(std::uint32_t callee);
+
+		std::uint32_t parse_type(bool complete);
+		std::uint32_t parse_declaration();
+
+		void open_rule(frame& current);
+		void match_rule(frame& current, typename token::kind expected);
+		void close_rule(const frame& current, const frame& parent);
+		void fold(const frame& current, typename node::kind type);
 
-		stream_info& m_stream;
-		token m_token;
-		node m_program;
-		declaration_list m_globals_view;
-		std::unordered_map<node*, declaration_list> m_variables_view;
+		stream_info* m_stream = nullptr;
+		const token_buffer* m_tokens = nullptr;
+		token_pipeline* m_pipeline = nullptr;
+		std::uint32_t m_index = 0; // next token in m_tokens
+		std::uint32_t m_last = ~std::uint32_t(0); // definitions start before this token
+		unsigned m_threads = 1;
+		bool m_lazy = false;
+		bool m_panic = false; // an error was reported, the rest of the construct is not
+		bool m_partial = false; // some error was reported or a parse threw, the tree is not fit for reparse
+		std::vector<parser_diagnostic>* m_diagnostics = nullptr; // errors are recorded here instead of thrown
+		token_buffer m_scanned; // tokens lexed from m_stream or m_pipeline
+		interner& m_symbols;
+		token_view m_token;
+		std::uint32_t m_token_index = 0;
+		ast m_tree;
+		std::uint32_t m_compacted = 0; // size of the tree after the last full parse or compaction
+		std::vector<std::uint32_t> m_pending; // children of the nodes being parsed
+		symbol_table m_scopes;
+		std::vector<std::pair<std::uint32_t, std::uint32_t>> m_unresolved; // use, symbol; may name a later global
 	};
 }
@@ -0,0 +1,11 @@
+#pragma once
+
+namespace cntlang
+{
+	using scanner = const char* (*)(const char* first, const char* last) noexcept;
+
+	// each returns the first position in [first, last) that does not continue the run
+	const char* scan_whitespace(const char* first, const char* last) noexcept;
+	const char* scan_line(const char* first, const char* last) noexcept; // stops at '\n' or eof
+	const char* scan_identifier(const char* first, const char* last) noexcept;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+namespace cntlang
+{
+	// Bounded single-producer/single-consumer queue. Each side owns one index and keeps a cached copy
+	// of the other, so the shared cache lines are only touched when the cached view runs out.
+	template<typename T, std::size_t Capacity>
+	class spsc_ring
+	{
+		static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "capacity must be a power of two");
+
+	public:
+		static constexpr std::size_t cache_line = 64;
+
+		std::size_t push(const T* items, std::size_t count) noexcept // producer; returns how many were queued
+		{
+			std::size_t tail = m_tail.load(std::memory_order_relaxed);
+
+			if (Capacity - (tail - m_cached_head) < count)
+				m_cached_head = m_head.load(std::memory_order_acquire);
+
+			std::size_t room = Capacity - (tail - m_cached_head);
+
+			if (count > room)
+				count = room;
+
+			for (std::size_t index = 0; index < count; ++index)
+				m_items[(tail + index) & (Capacity - 1)] = items[index];
+
+			m_tail.store(tail + count, std::memory_order_release);
+			return count;
+		}
+
+		std::size_t pop(T* items, std::size_t count) noexcept // consumer; returns how many were taken
+		{
+			std::size_t head = m_head.load(std::memory_order_relaxed);
+
+			if (m_cached_tail - head < count)
+				m_cached_tail = m_tail.load(std::memory_order_acquire);
+
+			std::size_t available = m_cached_tail - head;
+
+			if (count > available)
+				count = available;
+
+			for (std::size_t index = 0; index < count; ++index)
+				items[index] = m_items[(head + index) & (Capacity - 1)];
+
+			m_head.store(head + count, std::memory_order_release);
+			return count;
+		}
+
+	private:
+		alignas(cache_line) std::atomic<std::size_t> m_head{ 0 }; // written by the consumer
+		std::size_t m_cached_tail = 0;
+		alignas(cache_line) std::atomic<std::size_t> m_tail{ 0 }; // written by the producer
+		std::size_t m_cached_head = 0;
+		alignas(cache_line) T m_items[Capacity];
+	};
+}
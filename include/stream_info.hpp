@@ -4,6 +4,9 @@
 #include <cstddef>
 #include <istream>
 #include <string>
+#include <string_view>
+#include "line_index.hpp"
+#include "scan.hpp"
 
 namespace cntlang
 {
@@ -12,21 +15,43 @@ namespace cntlang
 	public:
 		static constexpr int eof = std::istream::traits_type::eof();
 
-		stream_info(std::istream& stream, std::string source = "<unnamed>", std::size_t bufferSize = 1024);
+		stream_info(std::istream& stream, std::string source = "<unnamed>", std::size_t bufferSize = 65536);
+		stream_info(std::string_view contents, std::string source = "<unnamed>");
 
 		const std::string& source() const noexcept;
-		int line() const noexcept;
-		int column() const noexcept;
+		std::size_t offset() const noexcept;
+		int line();
+		int column();
+		position locate();
+		position locate(std::size_t offset); // any offset already read
+		const line_index& lines();
+
+		std::size_t bytes_read() const noexcept;
+		std::size_t refills() const noexcept;
 
 		char peek();
 		char get();
 		char next();
+		void skip(scanner scan); // consumes the run scan matches, across chunks
+
+		void begin_lexeme() noexcept;
+		std::string_view end_lexeme() noexcept; // valid until the next read
 
 	private:
-		std::istream& m_stream;
+		bool refill();
+		void index_lines(const char* last);
+
+		std::istream* m_stream = nullptr; // null when serving from memory
 		std::string m_source;
 		std::vector<char> m_buffer;
-		int m_line = 1;
-		int m_column = 1;
+		const char* m_cursor = nullptr;
+		const char* m_end = nullptr;
+		const char* m_lexeme = nullptr;
+		const char* m_origin = nullptr; // window position of m_origin_offset
+		const char* m_indexed = nullptr; // line starts are known up to here
+		std::size_t m_origin_offset = 0;
+		std::size_t m_bytes_read = 0;
+		std::size_t m_refills = 0;
+		line_index m_lines;
 	};
 }
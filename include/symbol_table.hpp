@@ -0,0 +1,36 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+namespace cntlang
+{
+	// Nested scopes keyed by interned symbol. Each symbol heads a chain of the declarations that shadow
+	// one another; the entries double as the undo log, so leaving a scope only visits the names it declared.
+	class symbol_table
+	{
+	public:
+		static constexpr std::uint32_t not_found = ~std::uint32_t(0);
+
+		symbol_table(std::size_t expectedSymbols = 1024);
+
+		void push_scope();
+		void pop_scope() noexcept;
+		bool declare(std::uint32_t symbol, std::uint32_t declaration); // false if the innermost scope already has it
+		std::uint32_t lookup(std::uint32_t symbol) const noexcept; // innermost visible declaration
+		std::uint32_t depth() const noexcept;
+		void renumber(const std::vector<std::uint32_t>& declarations) noexcept; // after the nodes moved, the new index of each
+
+	private:
+		struct entry
+		{
+			std::uint32_t symbol;
+			std::uint32_t declaration;
+			std::uint32_t shadowed; // entry this one hides, not_found if none
+		};
+
+		std::vector<std::uint32_t> m_heads; // innermost entry per symbol; interned symbols are dense
+		std::vector<entry> m_entries; // in declaration order
+		std::vector<std::uint32_t> m_scopes; // first entry of each open scope
+	};
+}
@@ -1,14 +1,21 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 
 namespace cntlang
 {
+	union literal_value // decoded once by the lexer, integer for literal_int and real for literal_real
+	{
+		std::int64_t integer;
+		double real;
+	};
+
 	struct token
 	{
 		enum class kind
 		{
-			end_of_stream, whitespace, comment,
+			end_of_stream, whitespace, comment, error,
 			identifier,
 			literal_true, literal_false,
 			literal_int, literal_real,
@@ -31,5 +38,18 @@ namespace cntlang
 		kind type;
 		int line;
 		int column;
+		literal_value value;
+	};
+
+	// Lexeme is a range of the source; the text of a memory-backed source stays addressable through it,
+	// identifiers carry their interned symbol and error tokens their lexical_error::kind in symbol.
+	// Positions resolve through stream_info::locate(offset).
+	struct token_view
+	{
+		typename token::kind type;
+		std::uint32_t offset;
+		std::uint32_t length;
+		std::uint32_t symbol;
+		literal_value value;
 	};
 }
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include "interner.hpp"
+#include "line_index.hpp"
+#include "stream_info.hpp"
+#include "token.hpp"
+#include "tokenizer.hpp"
+#include "uninitialized_allocator.hpp"
+
+namespace cntlang
+{
+	struct text_edit
+	{
+		std::size_t offset;
+		std::size_t removed; // bytes of the old source
+		std::size_t inserted; // bytes of the new source
+	};
+
+	struct token_change // tokens [first, first + inserted) replaced [first, first + removed)
+	{
+		std::uint32_t first;
+		std::uint32_t removed;
+		std::uint32_t inserted;
+	};
+
+	// Structure-of-arrays token stream; the last token is always end_of_stream once tokenize() returns.
+	class token_buffer
+	{
+	public:
+		void reserve(std::size_t count);
+		void resize(std::size_t count); // the new tokens are left indeterminate until set
+		void push(const token_view& tkn);
+		void set(std::uint32_t index, const token_view& tkn) noexcept;
+		void splice(std::uint32_t first, std::uint32_t removed, const token_buffer& inserted, std::int64_t shift); // shift moves the tokens after
+		std::uint32_t find(std::uint32_t offset) const noexcept; // first token at or after offset
+
+		std::uint32_t size() const noexcept;
+		token_view operator[](std::uint32_t index) const noexcept;
+
+		typename token::kind type(std::uint32_t index) const noexcept;
+		std::uint32_t offset(std::uint32_t index) const noexcept;
+		std::uint32_t length(std::uint32_t index) const noexcept;
+		std::uint64_t payload(std::uint32_t index) const noexcept;
+
+		line_index& lines() noexcept;
+		const line_index& lines() const noexcept;
+		position locate(std::uint32_t index) const noexcept;
+
+	private:
+		static std::uint64_t encode_payload(const token_view& tkn) noexcept;
+
+		std::vector<std::uint8_t, uninitialized_allocator<std::uint8_t>> m_types;
+		std::vector<std::uint32_t, uninitialized_allocator<std::uint32_t>> m_offsets;
+		std::vector<std::uint32_t, uninitialized_allocator<std::uint32_t>> m_lengths;
+		std::vector<std::uint64_t, uninitialized_allocator<std::uint64_t>> m_payloads; // interned symbol of identifiers, bits of literal values
+		line_index m_lines;
+	};
+
+	token_buffer tokenize(stream_info& stream, interner& symbols);
+	token_buffer tokenize(stream_info& stream, interner& symbols, std::vector<lexical_diagnostic>& diagnostics);
+	token_buffer tokenize_parallel(std::string_view source, interner& symbols, unsigned threads); // same tokens, lexed in line-aligned chunks
+	// source is the edited text; errors in the tokens lexed again are reported, and stay in the buffer as error tokens
+	token_change relex(token_buffer& tokens, std::string_view source, const text_edit& edit, interner& symbols, std::vector<lexical_diagnostic>& diagnostics);
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <exception>
+#include <thread>
+#include <vector>
+#include "interner.hpp"
+#include "spsc_ring.hpp"
+#include "stream_info.hpp"
+#include "tokenizer.hpp"
+
+namespace cntlang
+{
+	// Lexes on a producer thread into a ring the consumer drains in batches. The stream and the interner
+	// belong to the producer until the pipeline is stopped; symbol ids may be compared meanwhile.
+	class token_pipeline
+	{
+	public:
+		static constexpr std::size_t batch_size = 256;
+
+		token_pipeline(stream_info& stream, interner& symbols);
+		token_pipeline(const token_pipeline&) = delete;
+		~token_pipeline();
+
+		token_pipeline& operator=(const token_pipeline&) = delete;
+
+		token_view next(); // throws lexical_error on the first error token like next_token
+		position locate(std::uint32_t offset); // stops the producer
+		const line_index& lines(); // stops the producer
+
+		void stop() noexcept;
+
+	private:
+		void produce() noexcept;
+		bool publish(const token_view* tokens, std::size_t count) noexcept;
+		void fill();
+
+		stream_info& m_stream;
+		interner& m_symbols;
+		spsc_ring<token_view, 8192> m_ring;
+		std::vector<lexical_diagnostic> m_diagnostics;
+		position m_error_position{};
+		std::exception_ptr m_exception;
+		std::atomic<bool> m_done{ false };
+		std::atomic<bool> m_stop{ false };
+		std::thread m_producer;
+		std::array<token_view, batch_size> m_batch;
+		std::size_t m_batch_size = 0;
+		std::size_t m_batch_index = 0;
+		token_view m_end{}; // handed out again once the stream is exhausted
+		bool m_exhausted = false;
+	};
+}
@@ -1,6 +1,9 @@
 #pragma once
 
+#include <cstdint>
 #include <stdexcept>
+#include <vector>
+#include "interner.hpp"
 #include "stream_info.hpp"
 #include "token.hpp"
 
@@ -13,10 +16,13 @@ namespace cntlang
 		{
 			expected_exponent,
 			unknown_intrinsic,
-			unexpected_symbol
+			unexpected_symbol,
+			literal_overflow
 		};
 
 		explicit lexical_error(kind error, int line, int column) noexcept;
+		static const char* describe(kind error) noexcept;
+		const char* what() const noexcept override;
 		kind error() const noexcept;
 		int line() const noexcept;
 		int column() const noexcept;
@@ -27,5 +33,13 @@ namespace cntlang
 		int m_column;
 	};
 
+	struct lexical_diagnostic
+	{
+		typename lexical_error::kind error;
+		std::uint32_t offset;
+	};
+
 	token next_token(stream_info& stream);
+	token_view next_token(stream_info& stream, interner& symbols);
+	token_view next_token(stream_info& stream, interner& symbols, std::vector<lexical_diagnostic>& diagnostics); // reports errors as error tokens
 }
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <string>
+#include "ast.hpp"
+#include "token_buffer.hpp"
+
+namespace cntlang
+{
+	// Hash-consed types: every distinct type is one 32-bit id, so equality is an integer compare.
+	// The low bits of an id are the modifiers and the rest index a base type; the primitives are fixed,
+	// function signatures are interned on first use and found again without allocating.
+	class type_table
+	{
+	public:
+		static constexpr std::uint32_t mutable_flag = 1;
+		static constexpr std::uint32_t reference_flag = 2;
+		static constexpr std::uint32_t modifier_bits = 2;
+		static constexpr std::uint32_t modifier_mask = (1u << modifier_bits) - 1;
+
+		static constexpr std::uint32_t none = 0u << modifier_bits;
+		static constexpr std::uint32_t boolean = 1u << modifier_bits;
+		static constexpr std::uint32_t integer = 2u << modifier_bits;
+		static constexpr std::uint32_t real = 3u << modifier_bits;
+		static constexpr std::uint32_t first_function = 4u << modifier_bits;
+
+		static constexpr std::uint32_t unknown = ~modifier_mask; // not deducible from the type alone (type!, parse errors)
+		static constexpr std::uint32_t invalid = unknown - (1u << modifier_bits); // ill-formed, e.g. a mut function type
+		static constexpr std::uint32_t not_found = invalid - (1u << modifier_bits); // a signature find() has not seen
+
+		type_table(std::size_t expectedSignatures = 64);
+
+		std::uint32_t function(std::uint32_t result, const std::uint32_t* parameters, std::uint32_t count);
+		std::uint32_t find(std::uint32_t result, const std::uint32_t* parameters, std::uint32_t count) const noexcept;
+		std::uint32_t intern(const ast& tree, const token_buffer& tokens, std::uint32_t type, const std::uint32_t* deduced = nullptr); // of a type or function_type node
+		std::uint32_t find(const ast& tree, const token_buffer& tokens, std::uint32_t type, const std::uint32_t* deduced, std::vector<std::uint32_t>& scratch) const;
+
+		static constexpr std::uint32_t dropmut(std::uint32_t type) noexcept { return type & ~mutable_flag; }
+		static constexpr std::uint32_t dropref(std::uint32_t type) noexcept { return type & ~reference_flag; }
+		static constexpr std::uint32_t base(std::uint32_t type) noexcept { return type & ~modifier_mask; }
+		static constexpr bool is_mutable(std::uint32_t type) noexcept { return type & mutable_flag; }
+		static constexpr bool is_reference(std::uint32_t type) noexcept { return type & reference_flag; }
+		static constexpr bool is_function(std::uint32_t type) noexcept { return base(type) >= first_function && base(type) < not_found; }
+		static constexpr bool is_complete(std::uint32_t type) noexcept { return base(type) != none && base(type) < not_found; }
+		static std::uint32_t qualify(std::uint32_t type, std::uint32_t modifiers) noexcept; // invalid on none and function types
+
+		std::uint32_t result(std::uint32_t function) const noexcept;
+		std::uint32_t parameter_count(std::uint32_t function) const noexcept;
+		const std::uint32_t* parameters(std::uint32_t function) const noexcept;
+		std::uint32_t size() const noexcept; // distinct base types, the primitives included
+		std::string name(std::uint32_t type) const; // as written in source, for diagnostics
+
+	private:
+		struct signature
+		{
+			std::uint32_t first; // result, then the parameters, in m_parameters
+			std::uint32_t count; // parameters only
+			std::uint32_t hashed;
+		};
+
+		template<typename Signature>
+		static std::uint32_t walk(const ast& tree, const token_buffer& tokens, std::uint32_t type, const std::uint32_t* deduced, std::vector<std::uint32_t>& scratch, Signature&& signature);
+		static std::uint32_t sentinel(std::uint32_t result, const std::uint32_t* parameters, std::uint32_t count) noexcept; // not_found, invalid or unknown among them, else 0
+		static std::uint32_t hash(std::uint32_t result, const std::uint32_t* parameters, std::uint32_t count) noexcept;
+		const signature& entry(std::uint32_t function) const noexcept;
+		void grow();
+
+		std::vector<std::uint32_t> m_parameters;
+		std::vector<signature> m_signatures;
+		std::vector<std::uint32_t> m_slots; // signature + 1, 0 when empty
+		std::vector<std::uint32_t> m_scratch; // parameters of the function types being interned, innermost last
+	};
+}
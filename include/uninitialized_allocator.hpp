@@ -0,0 +1,39 @@
+#pragma once
+
+#include <memory>
+#include <new>
+#include <utility>
+
+namespace cntlang
+{
+	// Default-initializes what resize() adds, so sizing a buffer that is about to be overwritten does not touch
+	// its memory; the writers then fault its pages in, in parallel.
+	template<typename T>
+	struct uninitialized_allocator : std::allocator<T>
+	{
+		template<typename U>
+		struct rebind
+		{
+			using other = uninitialized_allocator<U>;
+		};
+
+		uninitialized_allocator() noexcept = default;
+
+		template<typename U>
+		uninitialized_allocator(const uninitialized_allocator<U>&) noexcept
+		{
+		}
+
+		template<typename U>
+		void construct(U* place) noexcept
+		{
+			::new (static_cast<void*>(place)) U;
+		}
+
+		template<typename U, typename... Args>
+		void construct(U* place, Args&&... args)
+		{
+			::new (static_cast<void*>(place)) U(std::forward<Args>(args)...);
+		}
+	};
+}
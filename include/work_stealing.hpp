@@ -0,0 +1,103 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <thread>
+#include <vector>
+
+namespace cntlang
+{
+	// Threads beyond what the hardware runs at once only add switching to the work split among them.
+	inline unsigned usable_threads(unsigned requested) noexcept
+	{
+		unsigned hardware = std::thread::hardware_concurrency(); // 0 when unknown
+
+		return hardware != 0 && hardware < requested ? hardware : requested;
+	}
+
+	// Runs task(index, worker) once for every index in [0, count) on up to threads workers, the caller being worker 0.
+	// Each worker owns a range of indices and takes from its front; one that runs dry steals the back half of
+	// another's range. A range is one atomic word, and an index leaves every range once taken, so a
+	// compare-exchange on it never sees the same non-empty range twice.
+	template<typename Task>
+	void run_stealing(std::uint32_t count, unsigned threads, Task&& task)
+	{
+		constexpr std::size_t cache_line = 64;
+
+		struct alignas(cache_line) range
+		{
+			std::atomic<std::uint64_t> bounds; // first in the low half, last in the high half
+		};
+
+		auto pack = [](std::uint64_t first, std::uint64_t last) { return first | last << 32; };
+
+		if (threads > count)
+			threads = count;
+
+		if (threads < 2) {
+			for (std::uint32_t index = 0; index < count; ++index)
+				task(index, 0u);
+
+			return;
+		}
+
+		std::vector<range> ranges(threads);
+		std::vector<std::exception_ptr> errors(threads);
+		std::vector<std::thread> workers;
+
+		for (unsigned worker = 0; worker < threads; ++worker)
+			ranges[worker].bounds.store(pack(std::uint64_t(count) * worker / threads, std::uint64_t(count) * (worker + 1) / threads), std::memory_order_relaxed);
+
+		auto take = [&ranges, &pack, threads](unsigned worker, std::uint32_t& index) {
+			std::atomic<std::uint64_t>& own = ranges[worker].bounds;
+
+			for (std::uint64_t bounds = own.load(std::memory_order_acquire); std::uint32_t(bounds) < bounds >> 32;) {
+				if (own.compare_exchange_weak(bounds, pack(std::uint32_t(bounds) + 1, bounds >> 32), std::memory_order_acq_rel, std::memory_order_acquire)) {
+					index = std::uint32_t(bounds);
+					return true;
+				}
+			}
+
+			for (unsigned offset = 1; offset < threads; ++offset) {
+				std::atomic<std::uint64_t>& other = ranges[(worker + offset) % threads].bounds;
+
+				for (std::uint64_t bounds = other.load(std::memory_order_acquire); std::uint32_t(bounds) < bounds >> 32;) {
+					std::uint32_t first = std::uint32_t(bounds);
+					std::uint32_t last = std::uint32_t(bounds >> 32);
+					std::uint32_t middle = first + (last - first) / 2;
+
+					if (other.compare_exchange_weak(bounds, pack(first, middle), std::memory_order_acq_rel, std::memory_order_acquire)) {
+						own.store(pack(middle + 1, last), std::memory_order_release); // empty until now, so no thief is racing for it
+						index = middle;
+						return true;
+					}
+				}
+			}
+
+			return false; // what is still running was taken before, nothing is left to steal
+		};
+
+		auto work = [&task, &take, &errors](unsigned worker) {
+			try {
+				for (std::uint32_t index; take(worker, index);)
+					task(index, worker);
+			} catch (...) {
+				errors[worker] = std::current_exception();
+			}
+		};
+
+		for (unsigned worker = 1; worker < threads; ++worker)
+			workers.emplace_back(work, worker);
+
+		work(0);
+
+		for (auto& thread : workers)
+			thread.join();
+
+		for (auto& error : errors) {
+			if (error)
+				std::rethrow_exception(error);
+		}
+	}
+}
@@ -0,0 +1,624 @@
+#include <algorithm>
+#include "analyzer.hpp"
+#include "work_stealing.hpp"
+
+namespace cntlang
+{
+	semantic_error::semantic_error(kind error, int line, int column) noexcept
+	: m_error(error)
+	, m_line(line)
+	, m_column(column)
+	{
+	}
+
+	const char* semantic_error::describe(kind error) noexcept
+	{
+		switch (error) {
+		case kind::undeclared_identifier: return "name is not declared";
+		case kind::expected_bool: return "expected bool";
+		case kind::expected_number: return "expected int or real";
+		case kind::expected_int: return "expected int";
+		case kind::incompatible_types: return "incompatible types";
+		case kind::not_callable: return "called value is not a function";
+		case kind::wrong_argument_count: return "wrong number of arguments";
+		case kind::not_assignable: return "assigned value is not a mutable variable";
+		case kind::expected_variable: return "reference must name a variable";
+		case kind::immutable_reference: return "mutable reference to an immutable variable";
+		case kind::missing_initializer: return "references and functions must be initialized";
+		case kind::missing_return_value: return "expected return value";
+		case kind::unexpected_return_value: return "function returns none";
+		case kind::ill_formed_type: return "ill-formed type";
+		case kind::circular_type: return "type depends on itself";
+		case kind::loop_control_outside_loop: return "break or continue outside a loop";
+		}
+
+		return "semantic error";
+	}
+
+	const char* semantic_error::what() const noexcept
+	{
+		return describe(m_error);
+	}
+
+	semantic_error::kind semantic_error::error() const noexcept
+	{
+		return m_error;
+	}
+
+	int semantic_error::line() const noexcept
+	{
+		return m_line;
+	}
+
+	int semantic_error::column() const noexcept
+	{
+		return m_column;
+	}
+}
+
+namespace cntlang
+{
+	analyzer::analyzer(const ast& tree, const token_buffer& tokens, type_table& types, unsigned threads)
+	: m_tree(tree)
+	, m_tokens(tokens)
+	, m_types(types)
+	, m_threads(threads)
+	{
+	}
+
+	analyzer::analyzer(parser& source, type_table& types, unsigned threads)
+	: m_source(&source)
+	, m_tree(source.tree())
+	, m_tokens(source.tokens())
+	, m_types(types)
+	, m_threads(threads)
+	{
+	}
+
+	void analyzer::analyze()
+	{
+		std::vector<semantic_diagnostic> diagnostics;
+
+		analyze(diagnostics);
+
+		if (!diagnostics.empty()) {
+			auto [line, column] = m_tokens.lines().locate(diagnostics.front().offset);
+			throw semantic_error(diagnostics.front().error, line, column);
+		}
+	}
+
+	void analyzer::analyze(std::vector<semantic_diagnostic>& diagnostics)
+	{
+		std::vector<std::uint32_t> functions;
+		arena serial;
+
+		m_node_types.assign(m_tree.size(), type_table::unknown);
+		check_globals(serial);
+
+		for (std::uint32_t i = 0; i < m_tree[m_tree.root()].count; ++i) {
+			std::uint32_t definition = m_tree.child(m_tree.root(), i);
+
+			// a header that failed to parse leaves no body, a lazy one waits until it is named
+			if (m_tree[definition].type == node::kind::function_definition && m_tree[m_tree.child(definition, 2)].type == node::kind::statement_list)
+				functions.push_back(definition);
+		}
+
+		parse_reached(serial, functions);
+
+		std::size_t mark = diagnostics.size();
+
+		do { // each round checks the bodies the one before named first, the first also reports the globals
+			if (m_threads < 2 || functions.size() < 2) {
+				for (std::uint32_t definition : functions)
+					check_function(definition, serial);
+			} else {
+				std::vector<arena> arenas(std::min<std::size_t>(m_threads, functions.size()));
+
+				for (arena& local : arenas)
+					local.shared = true;
+
+				run_stealing(static_cast<std::uint32_t>(functions.size()), static_cast<unsigned>(arenas.size()), [this, &functions, &arenas](std::uint32_t index, unsigned worker) {
+					check_function(functions[index], arenas[worker]);
+				});
+
+				for (const arena& local : arenas) {
+					for (std::uint32_t definition : local.deferred) // may intern signatures now that no one else reads the table
+						check_function(definition, serial);
+				}
+
+				for (const arena& local : arenas) {
+					diagnostics.insert(diagnostics.end(), local.diagnostics.begin(), local.diagnostics.end());
+					serial.reached.insert(serial.reached.end(), local.reached.begin(), local.reached.end());
+				}
+			}
+
+			diagnostics.insert(diagnostics.end(), serial.diagnostics.begin(), serial.diagnostics.end());
+			serial.diagnostics.clear();
+			functions.clear();
+			parse_reached(serial, functions);
+		} while (!functions.empty());
+
+		// bodies cover disjoint ranges of the source, so this order does not depend on which worker took which body
+		std::stable_sort(diagnostics.begin() + mark, diagnostics.end(), [](const semantic_diagnostic& left, const semantic_diagnostic& right) {
+			return left.offset < right.offset;
+		});
+	}
+
+	void analyzer::analyze(std::vector<parser_diagnostic>& syntax, std::vector<semantic_diagnostic>& diagnostics)
+	{
+		m_syntax = &syntax;
+
+		try {
+			analyze(diagnostics);
+		} catch (...) {
+			m_syntax = nullptr;
+			throw;
+		}
+
+		m_syntax = nullptr;
+	}
+
+	std::uint32_t analyzer::type(std::uint32_t node) const noexcept
+	{
+		return m_node_types[node];
+	}
+
+	bool analyzer::poisoned(std::uint32_t type) noexcept
+	{
+		return type_table::base(type) >= type_table::not_found;
+	}
+
+	bool analyzer::numeric(std::uint32_t type) noexcept
+	{
+		return type_table::base(type) == type_table::integer || type_table::base(type) == type_table::real;
+	}
+
+	bool analyzer::convertible(std::uint32_t from, std::uint32_t to) noexcept
+	{
+		if (type_table::base(from) == type_table::none)
+			return false;
+
+		return type_table::base(from) == type_table::base(to) || (type_table::base(from) == type_table::integer && type_table::base(to) == type_table::real);
+	}
+
+	void analyzer::report(typename semantic_error::kind error, std::uint32_t at, arena& local)
+	{
+		local.diagnostics.push_back({ error, m_tokens.offset(m_tree.token(at)) });
+	}
+
+	bool analyzer::names_variable(std::uint32_t expression) const noexcept
+	{
+		return m_tree[expression].type == node::kind::primary_expression && m_tokens.type(m_tree.token(expression)) == token::kind::identifier
+			&& m_tree[m_tree.binding(expression)].type == node::kind::declaration;
+	}
+
+	void analyzer::check_globals(arena& local)
+	{
+		for (std::uint32_t i = 0; i < m_tree[m_tree.root()].count; ++i) {
+			std::uint32_t definition = m_tree.child(m_tree.root(), i);
+
+			if (m_tree[definition].type == node::kind::variable_definition)
+				check_initializer(m_tree.child(definition, 0), m_tree.child(definition, 1), local);
+			else if (m_tree[definition].type == node::kind::function_definition)
+				declared(definition, local); // its signature, so bodies only look signatures up
+		}
+	}
+
+	void analyzer::parse_reached(arena& local, std::vector<std::uint32_t>& functions)
+	{
+		if (!m_source) { // nothing can parse what was left lazy
+			local.reached.clear();
+			return;
+		}
+
+		// in source order, so the first syntax error thrown is the first among them
+		std::sort(local.reached.begin(), local.reached.end(), [this](std::uint32_t left, std::uint32_t right) {
+			return m_tree.token(left) < m_tree.token(right);
+		});
+		local.reached.erase(std::unique(local.reached.begin(), local.reached.end()), local.reached.end());
+
+		for (std::uint32_t definition : local.reached) {
+			if (m_tree[m_tree.child(definition, 2)].type == node::kind::lazy_body) {
+				if (m_syntax)
+					m_source->parse_body(definition, *m_syntax);
+				else
+					m_source->parse_body(definition);
+
+				functions.push_back(definition);
+			}
+		}
+
+		local.reached.clear();
+		m_node_types.resize(m_tree.size(), type_table::unknown); // the bodies' nodes
+	}
+
+	void analyzer::check_function(std::uint32_t definition, arena& local)
+	{
+		std::size_t mark = local.diagnostics.size();
+		std::uint32_t signature = declared(definition, local);
+
+		local.result = type_table::is_function(signature) ? m_types.result(signature) : type_table::invalid;
+		local.loops = 0;
+		local.missing = false;
+		check_statements(m_tree.child(definition, 2), local);
+
+		if (local.missing) {
+			local.diagnostics.resize(mark);
+			local.deferred.push_back(definition);
+		}
+	}
+
+	void analyzer::check_statements(std::uint32_t list, arena& local)
+	{
+		for (std::uint32_t i = 0; i < m_tree[list].count; ++i)
+			check_statement(m_tree.child(list, i), local);
+	}
+
+	void analyzer::check_statement(std::uint32_t statement, arena& local)
+	{
+		switch (m_tree[statement].type) {
+		case node::kind::variable_definition:
+			check_initializer(m_tree.child(statement, 0), m_tree.child(statement, 1), local);
+			break;
+		case node::kind::return_stmt: {
+			std::uint32_t value = m_tree.child(statement, 0);
+
+			if (value == ast::dummy) {
+				if (local.result != type_table::none && !poisoned(local.result))
+					report(semantic_error::kind::missing_return_value, statement, local);
+			} else if (local.result == type_table::none) {
+				expression(value, local);
+				report(semantic_error::kind::unexpected_return_value, value, local);
+			} else if (type_table::is_reference(local.result)) {
+				check_binding(local.result, value, local);
+			} else if (std::uint32_t type = expression(value, local); !poisoned(type) && !poisoned(local.result) && !convertible(type, local.result)) {
+				report(semantic_error::kind::incompatible_types, value, local);
+			}
+			break;
+		}
+		case node::kind::if_statement:
+		case node::kind::elseif_statement:
+			check_condition(m_tree.child(statement, 0), local);
+			check_statements(m_tree.child(statement, 1), local);
+
+			for (std::uint32_t i = 2; i < m_tree[statement].count; ++i) // elseif and else
+				check_statement(m_tree.child(statement, i), local);
+			break;
+		case node::kind::else_statement:
+			check_statements(m_tree.child(statement, 0), local);
+			break;
+		case node::kind::while_statement:
+			check_condition(m_tree.child(statement, 0), local);
+			++local.loops;
+			check_statements(m_tree.child(statement, 1), local);
+			--local.loops;
+			break;
+		case node::kind::for_statement: {
+			std::uint32_t counter = declared(m_tree.child(statement, 0), local);
+
+			if (!poisoned(counter) && !numeric(counter))
+				report(semantic_error::kind::expected_number, m_tree.child(statement, 0), local);
+
+			if (std::uint32_t start = expression(m_tree.child(statement, 1), local); !poisoned(start) && !poisoned(counter) && !convertible(start, counter))
+				report(semantic_error::kind::incompatible_types, m_tree.child(statement, 1), local);
+
+			check_number(m_tree.child(statement, 2), local); // limit
+
+			if (m_tree.child(statement, 3) != ast::dummy)
+				check_number(m_tree.child(statement, 3), local); // step
+
+			++local.loops;
+			check_statements(m_tree.child(statement, 4), local);
+			--local.loops;
+			break;
+		}
+		case node::kind::break_statement:
+		case node::kind::continue_statement:
+			if (local.loops == 0)
+				report(semantic_error::kind::loop_control_outside_loop, statement, local);
+			break;
+		case node::kind::error: // reported by the parser
+			break;
+		default:
+			expression(statement, local);
+			break;
+		}
+	}
+
+	void analyzer::check_initializer(std::uint32_t declaration, std::uint32_t value, arena& local)
+	{
+		std::uint32_t type = declared(declaration, local);
+
+		if (value == ast::dummy) {
+			if (type_table::is_reference(type) || type_table::is_function(type))
+				report(semantic_error::kind::missing_initializer, declaration, local);
+		} else if (type_table::is_reference(type)) {
+			check_binding(type, value, local);
+		} else if (std::uint32_t initial = expression(value, local); !poisoned(initial) && !poisoned(type) && !convertible(initial, type)) {
+			report(semantic_error::kind::incompatible_types, value, local);
+		}
+	}
+
+	void analyzer::check_condition(std::uint32_t expression, arena& local)
+	{
+		std::uint32_t type = this->expression(expression, local);
+
+		if (!poisoned(type) && type_table::base(type) != type_table::boolean)
+			report(semantic_error::kind::expected_bool, expression, local);
+	}
+
+	void analyzer::check_number(std::uint32_t expression, arena& local)
+	{
+		std::uint32_t type = this->expression(expression, local);
+
+		if (!poisoned(type) && !numeric(type))
+			report(semantic_error::kind::expected_number, expression, local);
+	}
+
+	void analyzer::check_binding(std::uint32_t reference, std::uint32_t value, arena& local)
+	{
+		std::uint32_t type = expression(value, local);
+
+		if (poisoned(type))
+			return;
+
+		if (!names_variable(value))
+			report(semantic_error::kind::expected_variable, value, local);
+		else if (type_table::base(type) != type_table::base(reference))
+			report(semantic_error::kind::incompatible_types, value, local);
+		else if (type_table::is_mutable(reference) && !type_table::is_mutable(type))
+			report(semantic_error::kind::immutable_reference, value, local);
+	}
+
+	std::uint32_t analyzer::declared(std::uint32_t declaration, arena& local)
+	{
+		if (m_node_types[declaration] != type_table::unknown)
+			return m_node_types[declaration];
+
+		if (std::find(local.resolving.begin(), local.resolving.end(), declaration) != local.resolving.end()) { // e.g. let a: type! b; let b: type! a;
+			report(semantic_error::kind::circular_type, declaration, local);
+			return m_node_types[declaration] = type_table::invalid;
+		}
+
+		std::uint32_t type = type_table::invalid;
+
+		local.resolving.push_back(declaration);
+
+		if (m_tree[declaration].type == node::kind::declaration) {
+			type = annotation(m_tree.child(declaration, 0), local);
+		} else if (m_tree[declaration].type == node::kind::function_definition) {
+			std::uint32_t parameters = m_tree.child(declaration, 0);
+			std::size_t mark = local.scratch.size();
+
+			for (std::uint32_t i = 0; i < m_tree[parameters].count; ++i) {
+				std::uint32_t parameter = declared(m_tree.child(parameters, i), local);
+
+				local.scratch.push_back(parameter);
+			}
+
+			std::uint32_t result = annotation(m_tree.child(declaration, 1), local);
+
+			type = local.shared ? m_types.find(result, local.scratch.data() + mark, m_tree[parameters].count)
+				: m_types.function(result, local.scratch.data() + mark, m_tree[parameters].count);
+			local.scratch.resize(mark);
+
+			if (type == type_table::not_found)
+				local.missing = true;
+
+			if (poisoned(type))
+				type = type_table::invalid; // the parts were reported
+		}
+
+		local.resolving.pop_back();
+
+		if (!local.missing) // a failed lookup is not the final word, keep it unknown
+			m_node_types[declaration] = type;
+
+		return type;
+	}
+
+	std::uint32_t analyzer::annotation(std::uint32_t type, arena& local)
+	{
+		bool deduced = deduce(type, local);
+		std::uint32_t annotated = local.shared ? m_types.find(m_tree, m_tokens, type, m_node_types.data(), local.scratch)
+			: m_types.intern(m_tree, m_tokens, type, m_node_types.data());
+
+		if (type_table::base(annotated) == type_table::not_found) {
+			local.missing = true;
+			return type_table::invalid;
+		}
+
+		if (type_table::base(annotated) == type_table::invalid && deduced)
+			report(semantic_error::kind::ill_formed_type, type, local);
+
+		return poisoned(annotated) ? type_table::invalid : annotated; // unknown where the parser failed
+	}
+
+	bool analyzer::deduce(std::uint32_t type, arena& local)
+	{
+		bool deduced = true;
+
+		if (m_tree[type].type == node::kind::type && m_tokens.type(m_tree.token(type)) == token::kind::intrinsic_type)
+			return !poisoned(expression(m_tree.child(type, m_tree[type].count - 1), local));
+
+		if (m_tree[type].type != node::kind::type && m_tree[type].type != node::kind::function_type)
+			return true;
+
+		for (std::uint32_t i = 0; i < m_tree[type].count; ++i)
+			deduced = deduce(m_tree.child(type, i), local) && deduced;
+
+		return deduced;
+	}
+
+	std::uint32_t analyzer::expression(std::uint32_t expression, arena& local)
+	{
+		std::uint32_t type = type_table::invalid;
+
+		switch (m_tree[expression].type) {
+		case node::kind::primary_expression:
+			switch (m_tokens.type(m_tree.token(expression))) {
+			case token::kind::literal_true:
+			case token::kind::literal_false:
+				type = type_table::boolean;
+				break;
+			case token::kind::literal_int:
+				type = type_table::integer;
+				break;
+			case token::kind::literal_real:
+				type = type_table::real;
+				break;
+			default:
+				if (m_tree.binding(expression) == ast::dummy) {
+					report(semantic_error::kind::undeclared_identifier, expression, local);
+					break;
+				}
+
+				if (m_tree[m_tree.binding(expression)].type == node::kind::function_definition)
+					local.reached.push_back(m_tree.binding(expression));
+
+				type = declared(m_tree.binding(expression), local);
+				break;
+			}
+			break;
+		case node::kind::intrinsic_expression: // line! and column!
+			type = type_table::integer;
+			break;
+		case node::kind::call_expression:
+			type = call(expression, local);
+			break;
+		case node::kind::unary_expression: {
+			std::uint32_t operand = this->expression(m_tree.child(expression, 0), local);
+
+			if (m_tokens.type(m_tree.token(expression)) == token::kind::logical_not) {
+				if (!poisoned(operand) && type_table::base(operand) != type_table::boolean)
+					report(semantic_error::kind::expected_bool, m_tree.child(expression, 0), local);
+
+				type = type_table::boolean;
+			} else if (numeric(operand)) {
+				type = type_table::base(operand);
+			} else if (!poisoned(operand)) {
+				report(semantic_error::kind::expected_number, m_tree.child(expression, 0), local);
+			}
+			break;
+		}
+		case node::kind::assignment_expression:
+		case node::kind::logical_expression:
+		case node::kind::relational_expression:
+		case node::kind::additive_expression:
+		case node::kind::multiplicative_expression:
+			type = operation(expression, local);
+			break;
+		default: // error, reported by the parser
+			break;
+		}
+
+		return m_node_types[expression] = type;
+	}
+
+	std::uint32_t analyzer::operation(std::uint32_t expression, arena& local)
+	{
+		std::uint32_t left = m_tree.child(expression, 0);
+		std::uint32_t right = m_tree.child(expression, 1);
+		std::uint32_t leftType = this->expression(left, local);
+		std::uint32_t rightType = this->expression(right, local);
+		typename token::kind op = m_tokens.type(m_tree.token(expression));
+		bool checked = !poisoned(leftType) && !poisoned(rightType);
+
+		switch (op) {
+		case token::kind::assign:
+		case token::kind::assign_add:
+		case token::kind::assign_subtract:
+		case token::kind::assign_multiply:
+		case token::kind::assign_divide:
+		case token::kind::assign_remainder:
+			if (!poisoned(leftType) && (!names_variable(left) || !type_table::is_mutable(leftType)))
+				report(semantic_error::kind::not_assignable, left, local);
+			else if (checked && op == token::kind::assign && !convertible(rightType, leftType))
+				report(semantic_error::kind::incompatible_types, right, local);
+			else if (checked && op == token::kind::assign_remainder && (type_table::base(leftType) != type_table::integer || type_table::base(rightType) != type_table::integer))
+				report(semantic_error::kind::expected_int, type_table::base(leftType) != type_table::integer ? left : right, local);
+			else if (checked && op != token::kind::assign && (!numeric(leftType) || !convertible(rightType, leftType)))
+				report(numeric(leftType) ? semantic_error::kind::incompatible_types : semantic_error::kind::expected_number, numeric(leftType) ? right : left, local);
+
+			return leftType;
+		case token::kind::logical_and:
+		case token::kind::logical_or:
+			if (!poisoned(leftType) && type_table::base(leftType) != type_table::boolean)
+				report(semantic_error::kind::expected_bool, left, local);
+
+			if (!poisoned(rightType) && type_table::base(rightType) != type_table::boolean)
+				report(semantic_error::kind::expected_bool, right, local);
+
+			return type_table::boolean;
+		case token::kind::equal:
+		case token::kind::not_equal:
+			if (checked && !(numeric(leftType) && numeric(rightType)) && !(type_table::base(leftType) == type_table::boolean && type_table::base(rightType) == type_table::boolean))
+				report(semantic_error::kind::incompatible_types, expression, local);
+
+			return type_table::boolean;
+		case token::kind::less:
+		case token::kind::less_or_equal:
+		case token::kind::greater:
+		case token::kind::greater_or_equal:
+			if (!poisoned(leftType) && !numeric(leftType))
+				report(semantic_error::kind::expected_number, left, local);
+
+			if (!poisoned(rightType) && !numeric(rightType))
+				report(semantic_error::kind::expected_number, right, local);
+
+			return type_table::boolean;
+		default: { // arithmetic, real if either side is
+			bool remainder = op == token::kind::remainder;
+
+			for (std::uint32_t operand : { left, right }) {
+				std::uint32_t operandType = operand == left ? leftType : rightType;
+
+				if (!poisoned(operandType) && (remainder ? type_table::base(operandType) != type_table::integer : !numeric(operandType)))
+					report(remainder ? semantic_error::kind::expected_int : semantic_error::kind::expected_number, operand, local);
+			}
+
+			if (!numeric(leftType) || !numeric(rightType))
+				return type_table::invalid;
+
+			return type_table::base(leftType) == type_table::real || type_table::base(rightType) == type_table::real ? type_table::real : type_table::integer;
+		}
+		}
+	}
+
+	std::uint32_t analyzer::call(std::uint32_t expression, arena& local)
+	{
+		std::uint32_t callee = m_tree.binding(expression);
+		std::uint32_t function = callee == ast::dummy ? type_table::invalid : declared(callee, local);
+		std::uint32_t arguments = m_tree[expression].count;
+
+		if (callee != ast::dummy && m_tree[callee].type == node::kind::function_definition)
+			local.reached.push_back(callee);
+
+		if (callee == ast::dummy)
+			report(semantic_error::kind::undeclared_identifier, expression, local);
+		else if (!poisoned(function) && !type_table::is_function(function))
+			report(semantic_error::kind::not_callable, expression, local);
+		else if (!poisoned(function) && m_types.parameter_count(function) != arguments)
+			report(semantic_error::kind::wrong_argument_count, expression, local);
+
+		if (!type_table::is_function(function)) {
+			for (std::uint32_t i = 0; i < arguments; ++i)
+				this->expression(m_tree.child(expression, i), local);
+
+			return type_table::invalid;
+		}
+
+		for (std::uint32_t i = 0; i < arguments; ++i) {
+			std::uint32_t argument = m_tree.child(expression, i);
+			std::uint32_t parameter = i < m_types.parameter_count(function) ? m_types.parameters(function)[i] : type_table::invalid;
+
+			if (type_table::is_reference(parameter)) {
+				check_binding(parameter, argument, local);
+			} else if (std::uint32_t type = this->expression(argument, local); !poisoned(type) && !poisoned(parameter) && !convertible(type, parameter)) {
+				report(semantic_error::kind::incompatible_types, argument, local);
+			}
+		}
+
+		return m_types.result(function);
+	}
+}
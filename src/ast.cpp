@@ -0,0 +1,228 @@
+#include "ast.hpp"
+
+using namespace cntlang;
+
+ast::ast()
+{
+	clear();
+}
+
+void ast::reserve(std::size_t nodes)
+{
+	m_nodes.reserve(nodes);
+	m_tokens.reserve(nodes);
+	m_children.reserve(nodes); // every node but the root is some node's child
+	m_bindings.reserve(nodes);
+}
+
+void ast::clear()
+{
+	m_nodes.clear();
+	m_tokens.clear();
+	m_children.clear();
+	m_bindings.clear();
+	m_nodes.push_back({ node::kind::dummy, 0, 0 });
+	m_tokens.push_back(node::no_token);
+	m_bindings.push_back(dummy);
+	m_root = dummy;
+}
+
+std::uint32_t ast::add(typename node::kind type, std::uint32_t token)
+{
+	m_nodes.push_back({ type, static_cast<std::uint32_t>(m_children.size()), 0 });
+	m_tokens.push_back(token);
+	m_bindings.push_back(dummy);
+	return static_cast<std::uint32_t>(m_nodes.size() - 1);
+}
+
+std::uint32_t ast::add(typename node::kind type, std::uint32_t token, const std::uint32_t* children, std::uint32_t count)
+{
+	auto first = static_cast<std::uint32_t>(m_children.size());
+
+	m_children.insert(m_children.end(), children, children + count);
+	m_nodes.push_back({ type, first, count });
+	m_tokens.push_back(token);
+	m_bindings.push_back(dummy);
+	return static_cast<std::uint32_t>(m_nodes.size() - 1);
+}
+
+void ast::set_children(std::uint32_t index, const std::uint32_t* children, std::uint32_t count)
+{
+	m_nodes[index].first = static_cast<std::uint32_t>(m_children.size());
+	m_nodes[index].count = count;
+	m_children.insert(m_children.end(), children, children + count);
+}
+
+void ast::set_child(std::uint32_t index, std::uint32_t nth, std::uint32_t child) noexcept
+{
+	m_children[m_nodes[index].first + nth] = child;
+}
+
+void ast::shift_tokens(std::uint32_t first, std::uint32_t removed, std::uint32_t inserted) noexcept
+{
+	for (std::uint32_t& token : m_tokens) {
+		if (token >= node::stale_token || token < first)
+			continue;
+
+		if (token < first + removed)
+			token = node::stale_token;
+		else
+			token = token - removed + inserted;
+	}
+}
+
+void ast::replace(std::uint32_t index, std::uint32_t with) noexcept
+{
+	m_nodes[index] = m_nodes[with];
+	m_tokens[index] = m_tokens[with];
+}
+
+void ast::rebind(std::uint32_t from, std::uint32_t to, std::uint32_t firstUse) noexcept
+{
+	for (std::uint32_t use = firstUse; use < size(); ++use) {
+		if (m_bindings[use] == from)
+			m_bindings[use] = to;
+	}
+}
+
+std::uint32_t ast::splice(const ast& other)
+{
+	auto bases = grow(other);
+
+	splice(other, bases);
+	return bases.first;
+}
+
+std::pair<std::uint32_t, std::uint32_t> ast::grow(const ast& other)
+{
+	std::uint32_t base = size() - 1; // both dummies are the same node
+	auto childBase = static_cast<std::uint32_t>(m_children.size());
+
+	m_nodes.resize(m_nodes.size() + other.size() - 1);
+	m_tokens.resize(m_tokens.size() + other.size() - 1);
+	m_bindings.resize(m_bindings.size() + other.size() - 1);
+	m_children.resize(m_children.size() + other.m_children.size());
+
+	return { base, childBase };
+}
+
+void ast::splice(const ast& other, std::pair<std::uint32_t, std::uint32_t> bases) noexcept
+{
+	auto [base, childBase] = bases;
+	auto shift = [base](std::uint32_t index) { return index == dummy ? dummy : index + base; };
+
+	for (std::uint32_t index = 1; index < other.size(); ++index) {
+		node copy = other.m_nodes[index];
+
+		copy.first += childBase;
+		m_nodes[base + index] = copy;
+		m_tokens[base + index] = other.m_tokens[index];
+		m_bindings[base + index] = shift(other.m_bindings[index]);
+	}
+
+	for (std::size_t index = 0; index < other.m_children.size(); ++index)
+		m_children[childBase + index] = shift(other.m_children[index]);
+}
+
+std::vector<std::uint32_t> ast::compact()
+{
+	std::vector<std::uint32_t> remap(size(), dummy);
+	std::vector<std::uint32_t> stack{ m_root };
+
+	while (!stack.empty()) { // marks what is reachable with anything but dummy
+		std::uint32_t index = stack.back();
+
+		stack.pop_back();
+
+		if (index == dummy || remap[index] != dummy)
+			continue;
+
+		remap[index] = index;
+
+		for (std::uint32_t nth = 0; nth < m_nodes[index].count; ++nth)
+			stack.push_back(child(index, nth));
+	}
+
+	// the kept nodes stay in order, so those added after a given node still come after it
+	std::uint32_t kept = 1;
+
+	for (std::uint32_t index = 1; index < size(); ++index) {
+		if (remap[index] != dummy)
+			remap[index] = kept++;
+	}
+
+	ast compacted;
+	std::uint32_t children = 0;
+
+	for (std::uint32_t index = 1; index < size(); ++index)
+		children += remap[index] != dummy ? m_nodes[index].count : 0;
+
+	compacted.m_nodes.resize(kept);
+	compacted.m_tokens.resize(kept);
+	compacted.m_bindings.resize(kept);
+	compacted.m_children.reserve(children);
+
+	for (std::uint32_t index = 1; index < size(); ++index) {
+		std::uint32_t to = remap[index];
+
+		if (to == dummy)
+			continue;
+
+		compacted.m_nodes[to] = { m_nodes[index].type, static_cast<std::uint32_t>(compacted.m_children.size()), m_nodes[index].count };
+		compacted.m_tokens[to] = m_tokens[index];
+		compacted.m_bindings[to] = remap[m_bindings[index]]; // a dropped declaration binds nothing
+
+		for (std::uint32_t nth = 0; nth < m_nodes[index].count; ++nth)
+			compacted.m_children.push_back(remap[child(index, nth)]);
+	}
+
+	compacted.m_root = remap[m_root];
+	*this = std::move(compacted);
+
+	return remap;
+}
+
+void ast::set_root(std::uint32_t index) noexcept
+{
+	m_root = index;
+}
+
+void ast::bind(std::uint32_t use, std::uint32_t declaration) noexcept
+{
+	m_bindings[use] = declaration;
+}
+
+std::uint32_t ast::root() const noexcept
+{
+	return m_root;
+}
+
+std::uint32_t ast::size() const noexcept
+{
+	return static_cast<std::uint32_t>(m_nodes.size());
+}
+
+const node& ast::operator[](std::uint32_t index) const noexcept
+{
+	return m_nodes[index];
+}
+
+std::uint32_t ast::token(std::uint32_t index) const noexcept
+{
+	return m_tokens[index];
+}
+
+const std::uint32_t* ast::children(std::uint32_t index) const noexcept
+{
+	return m_children.data() + m_nodes[index].first;
+}
+
+std::uint32_t ast::child(std::uint32_t index, std::uint32_t nth) const noexcept
+{
+	return m_children[m_nodes[index].first + nth];
+}
+
+std::uint32_t ast::binding(std::uint32_t use) const noexcept
+{
+	return m_bindings[use];
+}
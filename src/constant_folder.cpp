@@ -0,0 +1,350 @@
+#include <limits>
+#include "constant_folder.hpp"
+
+namespace cntlang
+{
+	constant_folder::constant_folder(const ast& tree, const token_buffer& tokens, const analyzer& types)
+	: m_tree(tree)
+	, m_tokens(tokens)
+	, m_types(types)
+	{
+	}
+
+	std::uint32_t constant_folder::fold()
+	{
+		m_values.assign(m_tree.size(), { type_table::none, {} });
+		m_definitions.assign(m_tree.size(), ast::dummy);
+		m_positions.assign(m_tree.size(), no_position);
+		m_states.assign(m_tree.size(), state::unvisited);
+		m_skipped = 0;
+		m_first_call = no_position;
+
+		for (std::uint32_t i = 0; i < m_tree[m_tree.root()].count; ++i) { // a function may name a global defined after it
+			std::uint32_t definition = m_tree.child(m_tree.root(), i);
+
+			if (m_tree[definition].type == node::kind::variable_definition) {
+				m_definitions[m_tree.child(definition, 0)] = definition;
+				m_positions[m_tree.child(definition, 0)] = i;
+
+				if (m_first_call == no_position && calls(m_tree.child(definition, 1)))
+					m_first_call = i;
+			}
+		}
+
+		fold_node(m_tree.root());
+		return m_skipped;
+	}
+
+	bool constant_folder::is_constant(std::uint32_t node) const noexcept
+	{
+		return m_values[node].type != type_table::none;
+	}
+
+	const constant& constant_folder::value(std::uint32_t node) const noexcept
+	{
+		return m_values[node];
+	}
+
+	bool constant_folder::convert(constant& folded, std::uint32_t type) noexcept
+	{
+		std::uint32_t base = type_table::base(type);
+
+		if (base == type_table::real && folded.type == type_table::integer) {
+			folded.value.real = static_cast<double>(folded.value.integer);
+			folded.type = type_table::real;
+		}
+
+		return folded.type == base;
+	}
+
+	bool constant_folder::calls(std::uint32_t node) const noexcept
+	{
+		if (m_tree[node].type == node::kind::call_expression)
+			return true;
+
+		for (std::uint32_t i = 0; i < m_tree[node].count; ++i) {
+			if (calls(m_tree.child(node, i)))
+				return true;
+		}
+
+		return false;
+	}
+
+	void constant_folder::fold_node(std::uint32_t node)
+	{
+		switch (m_tree[node].type) {
+		case node::kind::function_definition: {
+			// a body runs from a call, the earliest in the first initializer making one, or after every global
+			std::uint32_t initialized = m_initialized;
+
+			m_initialized = m_first_call;
+
+			for (std::uint32_t i = 0; i < m_tree[node].count; ++i)
+				fold_node(m_tree.child(node, i));
+
+			m_initialized = initialized;
+			break;
+		}
+		case node::kind::program:
+		case node::kind::statement_list:
+		case node::kind::return_stmt:
+		case node::kind::if_statement:
+		case node::kind::elseif_statement:
+		case node::kind::else_statement:
+		case node::kind::while_statement:
+		case node::kind::for_statement:
+			for (std::uint32_t i = 0; i < m_tree[node].count; ++i)
+				fold_node(m_tree.child(node, i));
+			break;
+		case node::kind::variable_definition:
+			fold_definition(node);
+			break;
+		case node::kind::assignment_expression:
+		case node::kind::logical_expression:
+		case node::kind::relational_expression:
+		case node::kind::additive_expression:
+		case node::kind::multiplicative_expression:
+		case node::kind::unary_expression:
+		case node::kind::primary_expression:
+		case node::kind::call_expression:
+		case node::kind::intrinsic_expression:
+			fold_expression(node);
+			break;
+		default: // declarations and types, type! does not evaluate its expression
+			break;
+		}
+	}
+
+	void constant_folder::fold_definition(std::uint32_t definition)
+	{
+		std::uint32_t declaration = m_tree.child(definition, 0);
+		std::uint32_t initializer = m_tree.child(definition, 1);
+		std::uint32_t type = m_types.type(declaration);
+
+		if (m_states[declaration] != state::unvisited) // done, or named in its own initializer
+			return;
+
+		std::uint32_t initialized = m_initialized;
+
+		m_states[declaration] = state::visiting;
+
+		if (m_positions[declaration] != no_position)
+			m_initialized = m_positions[declaration];
+
+		if (initializer != ast::dummy && fold_expression(initializer) && !type_table::is_mutable(type) && !type_table::is_reference(type)) {
+			constant folded = m_values[initializer];
+
+			if (convert(folded, type))
+				m_values[declaration] = folded;
+		}
+
+		m_initialized = initialized;
+		m_states[declaration] = state::done;
+	}
+
+	bool constant_folder::fold_expression(std::uint32_t expression)
+	{
+		constant& folded = m_values[expression];
+		token_view tkn = m_tokens[m_tree.token(expression)];
+
+		switch (m_tree[expression].type) {
+		case node::kind::primary_expression:
+			switch (tkn.type) {
+			case token::kind::literal_true:
+			case token::kind::literal_false:
+				folded.type = type_table::boolean;
+				folded.value.integer = tkn.type == token::kind::literal_true;
+				return true;
+			case token::kind::literal_int:
+				folded = { type_table::integer, tkn.value };
+				return true;
+			case token::kind::literal_real:
+				folded = { type_table::real, tkn.value };
+				return true;
+			default:
+				return fold_name(expression);
+			}
+		case node::kind::intrinsic_expression: {
+			position where = m_tokens.locate(m_tree.token(expression));
+
+			folded.type = type_table::integer;
+			folded.value.integer = tkn.type == token::kind::intrinsic_line ? where.line : where.column;
+			return true;
+		}
+		case node::kind::unary_expression:
+			return fold_unary(expression);
+		case node::kind::assignment_expression:
+			fold_expression(m_tree.child(expression, 1)); // the target is not read
+			return false;
+		case node::kind::logical_expression:
+		case node::kind::relational_expression:
+		case node::kind::additive_expression:
+		case node::kind::multiplicative_expression:
+			return fold_binary(expression);
+		case node::kind::call_expression:
+			for (std::uint32_t i = 0; i < m_tree[expression].count; ++i)
+				fold_expression(m_tree.child(expression, i));
+			return false;
+		default:
+			return false;
+		}
+	}
+
+	bool constant_folder::fold_name(std::uint32_t expression)
+	{
+		std::uint32_t declaration = m_tree.binding(expression);
+
+		if (m_tree[declaration].type != node::kind::declaration) // a function or an unresolved name
+			return false;
+
+		if (m_positions[declaration] != no_position && m_positions[declaration] >= m_initialized) // runs after this initializer
+			return false;
+
+		if (m_definitions[declaration] != ast::dummy)
+			fold_definition(m_definitions[declaration]);
+
+		if (!is_constant(declaration)) // mutable, a reference, a parameter or a for counter
+			return false;
+
+		m_values[expression] = m_values[declaration];
+		return true;
+	}
+
+	bool constant_folder::fold_unary(std::uint32_t expression)
+	{
+		std::uint32_t operand = m_tree.child(expression, 0);
+
+		if (!fold_expression(operand) || !evaluate(m_tokens.type(m_tree.token(expression)), m_values[operand], m_values[expression]))
+			return false;
+
+		++m_skipped;
+		return true;
+	}
+
+	bool constant_folder::fold_binary(std::uint32_t expression)
+	{
+		std::uint32_t left = m_tree.child(expression, 0);
+		std::uint32_t right = m_tree.child(expression, 1);
+		bool folded = fold_expression(left);
+
+		folded = fold_expression(right) && folded; // either way, it may hold constants
+
+		if (!folded || !evaluate(m_tokens.type(m_tree.token(expression)), m_values[left], m_values[right], m_values[expression]))
+			return false;
+
+		m_skipped += 2;
+		return true;
+	}
+
+	bool constant_folder::evaluate(typename token::kind op, constant operand, constant& result) noexcept
+	{
+		if (op == token::kind::logical_not)
+			operand.value.integer = !operand.value.integer;
+		else if (operand.type == type_table::real)
+			operand.value.real = -operand.value.real;
+		else if (operand.value.integer == std::numeric_limits<std::int64_t>::min())
+			return false;
+		else
+			operand.value.integer = -operand.value.integer;
+
+		result = operand;
+		return true;
+	}
+
+	bool constant_folder::evaluate(typename token::kind op, constant left, constant right, constant& result) noexcept
+	{
+		constant folded{ type_table::boolean, {} };
+
+		if (left.type == type_table::real || right.type == type_table::real) { // int widens, as in analyzer
+			convert(left, type_table::real);
+			convert(right, type_table::real);
+		}
+
+		double x = left.value.real;
+		double y = right.value.real;
+		std::int64_t a = left.value.integer;
+		std::int64_t b = right.value.integer;
+		bool real = left.type == type_table::real;
+
+		switch (op) {
+		case token::kind::logical_and: folded.value.integer = a && b; break;
+		case token::kind::logical_or: folded.value.integer = a || b; break;
+		case token::kind::equal: folded.value.integer = real ? x == y : a == b; break;
+		case token::kind::not_equal: folded.value.integer = real ? x != y : a != b; break;
+		case token::kind::less: folded.value.integer = real ? x < y : a < b; break;
+		case token::kind::less_or_equal: folded.value.integer = real ? x <= y : a <= b; break;
+		case token::kind::greater: folded.value.integer = real ? x > y : a > b; break;
+		case token::kind::greater_or_equal: folded.value.integer = real ? x >= y : a >= b; break;
+		default:
+			if (!real) {
+				folded.type = type_table::integer;
+
+				if (!arithmetic(op, a, b, folded.value.integer))
+					return false;
+
+				break;
+			}
+
+			folded.type = type_table::real;
+
+			switch (op) {
+			case token::kind::add: folded.value.real = x + y; break;
+			case token::kind::subtract: folded.value.real = x - y; break;
+			case token::kind::multiply: folded.value.real = x * y; break;
+			case token::kind::divide:
+				if (y == 0.0)
+					return false;
+
+				folded.value.real = x / y;
+				break;
+			default: // remainder is int only
+				return false;
+			}
+			break;
+		}
+
+		result = folded;
+		return true;
+	}
+
+	bool constant_folder::arithmetic(typename token::kind op, std::int64_t left, std::int64_t right, std::int64_t& result) noexcept
+	{
+		constexpr std::int64_t min = std::numeric_limits<std::int64_t>::min();
+		constexpr std::int64_t max = std::numeric_limits<std::int64_t>::max();
+
+		switch (op) {
+		case token::kind::add:
+			if ((right > 0 && left > max - right) || (right < 0 && left < min - right))
+				return false;
+
+			result = left + right;
+			return true;
+		case token::kind::subtract:
+			if ((right < 0 && left > max + right) || (right > 0 && left < min + right))
+				return false;
+
+			result = left - right;
+			return true;
+		case token::kind::multiply:
+			if (left > 0 ? (right > 0 ? left > max / right : right < min / left) : (right > 0 ? left < min / right : left != 0 && right < max / left))
+				return false;
+
+			result = left * right;
+			return true;
+		case token::kind::divide:
+			if (right == 0 || (left == min && right == -1))
+				return false;
+
+			result = left / right; // truncates toward zero
+			return true;
+		case token::kind::remainder:
+			if (right == 0)
+				return false;
+
+			result = right == -1 ? 0 : left % right; // min % -1 overflows in C++, the remainder is still 0
+			return true;
+		default:
+			return false;
+		}
+	}
+}
@@ -0,0 +1,383 @@
+#include "evaluator.hpp"
+
+namespace cntlang
+{
+	constexpr typename token::kind compound_operator(typename token::kind kind) noexcept // of an assignment, assign itself for plain =
+	{
+		switch (kind) {
+		case token::kind::assign_add: return token::kind::add;
+		case token::kind::assign_subtract: return token::kind::subtract;
+		case token::kind::assign_multiply: return token::kind::multiply;
+		case token::kind::assign_divide: return token::kind::divide;
+		case token::kind::assign_remainder: return token::kind::remainder;
+		default: return token::kind::assign;
+		}
+	}
+
+	evaluator::evaluator(const ast& tree, const token_buffer& tokens, const analyzer& types, const type_table& table, const constant_folder& constants, std::uint64_t steps)
+	: m_tree(tree)
+	, m_tokens(tokens)
+	, m_types(types)
+	, m_table(table)
+	, m_constants(constants)
+	, m_budget(steps)
+	{
+	}
+
+	globals_image evaluator::evaluate()
+	{
+		globals_image image;
+		std::uint32_t program = m_tree.root();
+
+		m_globals.assign(m_tree.size(), { type_table::none, {} });
+		m_order.assign(m_tree.size(), no_slot);
+		m_slots.assign(m_tree.size(), no_slot);
+		m_frames.assign(m_tree.size(), no_slot);
+		m_effects.assign(m_tree.size(), effect::unknown);
+
+		for (std::uint32_t i = 0; i < m_tree[program].count; ++i) {
+			if (m_tree[m_tree.child(program, i)].type == node::kind::variable_definition)
+				m_order[m_tree.child(m_tree.child(program, i), 0)] = i;
+		}
+
+		for (std::uint32_t i = 0; i < m_tree[program].count; ++i) {
+			std::uint32_t definition = m_tree.child(program, i);
+
+			if (m_tree[definition].type != node::kind::variable_definition)
+				continue;
+
+			std::uint32_t declaration = m_tree.child(definition, 0);
+			std::uint32_t initializer = m_tree.child(definition, 1);
+			std::uint32_t type = m_types.type(declaration);
+			constant value{ type_table::none, {} };
+
+			m_current = i;
+			m_steps = m_budget;
+			m_depth = 0;
+			m_base = 0;
+			m_stack.clear();
+
+			if (initializer != ast::dummy && !type_table::is_reference(type) && evaluate(initializer, value) && constant_folder::convert(value, type)) {
+				m_globals[declaration] = value;
+				image.declarations.push_back(declaration);
+				image.values.push_back(value);
+			} else {
+				image.pending.push_back(definition);
+			}
+		}
+
+		return image;
+	}
+
+	std::uint32_t evaluator::layout(std::uint32_t function)
+	{
+		if (m_frames[function] != no_slot)
+			return m_frames[function];
+
+		std::uint32_t parameters = m_tree.child(function, 0);
+		std::uint32_t slots = 0;
+
+		for (std::uint32_t i = 0; i < m_tree[parameters].count; ++i) // the arguments are pushed into the first slots
+			m_slots[m_tree.child(parameters, i)] = slots++;
+
+		assign_slots(m_tree.child(function, 2), slots);
+		return m_frames[function] = slots;
+	}
+
+	void evaluator::assign_slots(std::uint32_t statement, std::uint32_t& slots)
+	{
+		switch (m_tree[statement].type) {
+		case node::kind::variable_definition:
+		case node::kind::for_statement:
+			m_slots[m_tree.child(statement, 0)] = slots++;
+			[[fallthrough]];
+		case node::kind::statement_list:
+		case node::kind::if_statement:
+		case node::kind::elseif_statement:
+		case node::kind::else_statement:
+		case node::kind::while_statement:
+			for (std::uint32_t i = 0; i < m_tree[statement].count; ++i)
+				assign_slots(m_tree.child(statement, i), slots);
+			break;
+		default:
+			break;
+		}
+	}
+
+	bool evaluator::step() noexcept
+	{
+		if (m_steps == 0)
+			return false;
+
+		--m_steps;
+		return true;
+	}
+
+	typename evaluator::outcome evaluator::execute(std::uint32_t statement)
+	{
+		if (!step())
+			return outcome::failed;
+
+		switch (m_tree[statement].type) {
+		case node::kind::statement_list:
+			return execute_list(statement);
+		case node::kind::variable_definition: {
+			std::uint32_t declaration = m_tree.child(statement, 0);
+			std::uint32_t initializer = m_tree.child(statement, 1);
+			std::uint32_t type = m_types.type(declaration);
+			std::uint32_t slot = m_base + m_slots[declaration]; // not a reference, calls grow the stack
+			constant value{ type_table::none, {} }; // default initialized, reading it fails
+
+			if (type_table::is_reference(type))
+				return outcome::failed;
+
+			if (initializer != ast::dummy && (!evaluate(initializer, value) || !constant_folder::convert(value, type)))
+				return outcome::failed;
+
+			m_stack[slot] = value;
+			return outcome::next;
+		}
+		case node::kind::return_stmt:
+			m_result = { type_table::none, {} };
+
+			if (m_tree.child(statement, 0) != ast::dummy && !evaluate(m_tree.child(statement, 0), m_result))
+				return outcome::failed;
+
+			return outcome::returned;
+		case node::kind::if_statement: {
+			bool taken = false;
+
+			if (!condition(m_tree.child(statement, 0), taken))
+				return outcome::failed;
+
+			if (taken)
+				return execute_list(m_tree.child(statement, 1));
+
+			for (std::uint32_t i = 2; i < m_tree[statement].count; ++i) {
+				std::uint32_t branch = m_tree.child(statement, i);
+
+				if (m_tree[branch].type == node::kind::else_statement)
+					return execute_list(m_tree.child(branch, 0));
+
+				if (!condition(m_tree.child(branch, 0), taken))
+					return outcome::failed;
+
+				if (taken)
+					return execute_list(m_tree.child(branch, 1));
+			}
+
+			return outcome::next;
+		}
+		case node::kind::while_statement:
+			return execute_while(statement);
+		case node::kind::break_statement:
+			return outcome::broke;
+		case node::kind::continue_statement:
+			return outcome::continued;
+		case node::kind::for_statement: // the language does not pin down its bounds yet
+		case node::kind::error:
+			return outcome::failed;
+		default: {
+			constant discarded;
+
+			return evaluate(statement, discarded) ? outcome::next : outcome::failed;
+		}
+		}
+	}
+
+	typename evaluator::outcome evaluator::execute_list(std::uint32_t list)
+	{
+		for (std::uint32_t i = 0; i < m_tree[list].count; ++i) {
+			outcome result = execute(m_tree.child(list, i));
+
+			if (result != outcome::next)
+				return result;
+		}
+
+		return outcome::next;
+	}
+
+	typename evaluator::outcome evaluator::execute_while(std::uint32_t statement)
+	{
+		for (;;) {
+			bool taken = false;
+
+			if (!condition(m_tree.child(statement, 0), taken))
+				return outcome::failed;
+
+			if (!taken)
+				return outcome::next;
+
+			outcome result = execute_list(m_tree.child(statement, 1));
+
+			if (result == outcome::broke)
+				return outcome::next;
+
+			if (result == outcome::returned || result == outcome::failed)
+				return result;
+		}
+	}
+
+	bool evaluator::evaluate(std::uint32_t expression, constant& result)
+	{
+		if (!step())
+			return false;
+
+		// a global is read whether folded or not, it may not be set yet when a body runs from an earlier initializer
+		bool global = m_tree[expression].type == node::kind::primary_expression && m_order[m_tree.binding(expression)] != no_slot;
+
+		if (m_constants.is_constant(expression) && !global) {
+			result = m_constants.value(expression);
+			return true;
+		}
+
+		typename token::kind op = m_tokens.type(m_tree.token(expression));
+
+		switch (m_tree[expression].type) {
+		case node::kind::primary_expression: // a name, literals are constant
+			return read(m_tree.binding(expression), result);
+		case node::kind::unary_expression: {
+			constant operand;
+
+			return evaluate(m_tree.child(expression, 0), operand) && constant_folder::evaluate(op, operand, result);
+		}
+		case node::kind::logical_expression: // both sides, whether the right one runs is not pinned down yet
+			if (effects(m_tree.child(expression, 1)))
+				return false;
+			[[fallthrough]];
+		case node::kind::relational_expression:
+		case node::kind::additive_expression:
+		case node::kind::multiplicative_expression: {
+			constant left;
+			constant right;
+
+			return evaluate(m_tree.child(expression, 0), left) && evaluate(m_tree.child(expression, 1), right)
+				&& constant_folder::evaluate(op, left, right, result);
+		}
+		case node::kind::assignment_expression:
+			return assign(expression, result);
+		case node::kind::call_expression:
+			return call(expression, result);
+		default:
+			return false;
+		}
+	}
+
+	bool evaluator::effects(std::uint32_t expression)
+	{
+		if (m_effects[expression] != effect::unknown)
+			return m_effects[expression] == effect::some;
+
+		bool some = m_tree[expression].type == node::kind::call_expression || m_tree[expression].type == node::kind::assignment_expression;
+
+		for (std::uint32_t i = 0; i < m_tree[expression].count && !some; ++i)
+			some = effects(m_tree.child(expression, i));
+
+		m_effects[expression] = some ? effect::some : effect::none;
+		return some;
+	}
+
+	bool evaluator::condition(std::uint32_t expression, bool& result)
+	{
+		constant value;
+
+		if (!evaluate(expression, value))
+			return false;
+
+		result = value.value.integer != 0;
+		return true;
+	}
+
+	bool evaluator::read(std::uint32_t declaration, constant& result)
+	{
+		if (m_tree[declaration].type == node::kind::function_definition) {
+			result.type = m_types.type(declaration);
+			result.value.integer = declaration;
+			return type_table::is_function(result.type);
+		}
+
+		if (m_tree[declaration].type != node::kind::declaration)
+			return false;
+
+		if (m_slots[declaration] != no_slot) { // a local of the function running
+			result = m_stack[m_base + m_slots[declaration]];
+			return result.type != type_table::none;
+		}
+
+		// a global initialized before this one, which no initializer left to run can have changed
+		result = m_globals[declaration];
+		return m_order[declaration] < m_current && result.type != type_table::none && !type_table::is_mutable(m_types.type(declaration));
+	}
+
+	bool evaluator::assign(std::uint32_t expression, constant& result)
+	{
+		std::uint32_t target = m_tree.binding(m_tree.child(expression, 0));
+		typename token::kind op = compound_operator(m_tokens.type(m_tree.token(expression)));
+		constant value;
+
+		if (m_tree[target].type != node::kind::declaration || m_slots[target] == no_slot) // globals are not written
+			return false;
+
+		if (!evaluate(m_tree.child(expression, 1), value))
+			return false;
+
+		if (op != token::kind::assign) {
+			constant current = m_stack[m_base + m_slots[target]];
+
+			if (current.type == type_table::none || !constant_folder::evaluate(op, current, value, value))
+				return false;
+		}
+
+		if (!constant_folder::convert(value, m_types.type(target)))
+			return false;
+
+		result = m_stack[m_base + m_slots[target]] = value;
+		return true;
+	}
+
+	bool evaluator::call(std::uint32_t expression, constant& result)
+	{
+		constant callee;
+
+		if (!read(m_tree.binding(expression), callee) || !type_table::is_function(callee.type) || m_depth >= max_depth)
+			return false;
+
+		auto function = static_cast<std::uint32_t>(callee.value.integer);
+		std::uint32_t parameters = m_tree.child(function, 0);
+		std::uint32_t returns = m_table.result(m_types.type(function));
+		auto base = static_cast<std::uint32_t>(m_stack.size());
+
+		if (m_tree[m_tree.child(function, 2)].type != node::kind::statement_list || type_table::is_reference(returns)) // a body left lazy or lost to a broken header
+			return false;
+
+		std::uint32_t frame = layout(function);
+
+		for (std::uint32_t i = 0; i < m_tree[expression].count; ++i) {
+			constant argument;
+			std::uint32_t type = m_types.type(m_tree.child(parameters, i));
+
+			if (type_table::is_reference(type) || !evaluate(m_tree.child(expression, i), argument) || !constant_folder::convert(argument, type))
+				return false;
+
+			m_stack.push_back(argument);
+		}
+
+		std::uint32_t caller = m_base;
+
+		m_stack.resize(base + frame, { type_table::none, {} });
+		m_base = base;
+		++m_depth;
+
+		outcome ended = execute_list(m_tree.child(function, 2));
+
+		--m_depth;
+		m_base = caller;
+		m_stack.resize(base);
+		result = returns == type_table::none ? constant{ type_table::none, {} } : m_result;
+
+		if (ended == outcome::next) // ran off the end, only a none function may
+			return returns == type_table::none;
+
+		return ended == outcome::returned && (returns == type_table::none || constant_folder::convert(result, returns));
+	}
+}
@@ -0,0 +1,81 @@
+#include "interner.hpp"
+
+using namespace cntlang;
+
+interner::interner(std::size_t expectedSymbols)
+{
+	std::size_t capacity = 16;
+
+	while (capacity < expectedSymbols * 2)
+		capacity *= 2;
+
+	m_characters.reserve(expectedSymbols * 8);
+	m_offsets.reserve(expectedSymbols + 1);
+	m_offsets.push_back(0);
+	m_hashes.reserve(expectedSymbols);
+	m_slots.resize(capacity);
+}
+
+std::uint32_t interner::intern(std::string_view name)
+{
+	std::uint32_t hashed = hash(name);
+	std::size_t mask = m_slots.size() - 1;
+
+	for (std::size_t slot = hashed & mask;; slot = (slot + 1) & mask) {
+		std::uint32_t entry = m_slots[slot];
+
+		if (entry == 0) {
+			std::uint32_t symbol = size();
+
+			m_characters.insert(m_characters.end(), name.begin(), name.end());
+			m_offsets.push_back(static_cast<std::uint32_t>(m_characters.size()));
+			m_hashes.push_back(hashed);
+			m_slots[slot] = symbol + 1;
+
+			if (size() * 2 > m_slots.size())
+				grow();
+
+			return symbol;
+		}
+
+		if (m_hashes[entry - 1] == hashed && this->name(entry - 1) == name)
+			return entry - 1;
+	}
+}
+
+std::string_view interner::name(std::uint32_t symbol) const noexcept
+{
+	return std::string_view(m_characters.data() + m_offsets[symbol], m_offsets[symbol + 1] - m_offsets[symbol]);
+}
+
+std::uint32_t interner::size() const noexcept
+{
+	return static_cast<std::uint32_t>(m_hashes.size());
+}
+
+std::uint32_t interner::hash(std::string_view name) noexcept // FNV-1a
+{
+	std::uint32_t hashed = 2166136261u;
+
+	for (char chr : name)
+		hashed = (hashed ^ static_cast<unsigned char>(chr)) * 16777619u;
+
+	return hashed;
+}
+
+void interner::grow()
+{
+	std::vector<std::uint32_t> slots(m_slots.size() * 2);
+	std::size_t mask = slots.size() - 1;
+
+	for (std::uint32_t symbol = 0; symbol < size(); ++symbol) {
+		std::size_t slot = m_hashes[symbol] & mask;
+
+		while (slots[slot] != 0)
+			slot = (slot + 1) & mask;
+
+		slots[slot] = symbol + 1;
+	}
+
+	m_slots = std::move(slots);
+}
@@ -0,0 +1,67 @@
+#include <algorithm>
+#include <cstring>
+#include "line_index.hpp"
+
+using namespace cntlang;
+
+line_index::line_index()
+: m_starts({ 0 })
+{
+}
+
+void line_index::scan(const char* first, const char* last, std::size_t offset)
+{
+	for (const char* it = first; (it = static_cast<const char*>(std::memchr(it, '\n', last - it))); ++it)
+		m_starts.push_back(offset + (it - first) + 1);
+}
+
+void line_index::append(std::size_t lineStart)
+{
+	m_starts.push_back(lineStart);
+}
+
+void line_index::append(const line_index& other, std::size_t offset)
+{
+	m_starts.reserve(m_starts.size() + other.m_starts.size() - 1);
+
+	for (std::size_t line = 1; line < other.m_starts.size(); ++line)
+		m_starts.push_back(other.m_starts[line] + offset);
+}
+
+void line_index::edit(std::size_t offset, std::size_t removed, std::string_view inserted)
+{
+	auto first = std::upper_bound(m_starts.begin(), m_starts.end(), offset);
+	auto last = std::upper_bound(first, m_starts.end(), offset + removed);
+	std::vector<std::size_t> starts;
+
+	for (std::size_t index = 0; index < inserted.size(); ++index)
+		if (inserted[index] == '\n')
+			starts.push_back(offset + index + 1);
+
+	for (auto it = last; it != m_starts.end(); ++it)
+		*it = *it - removed + inserted.size();
+
+	m_starts.insert(m_starts.erase(first, last), starts.begin(), starts.end());
+}
+
+position line_index::locate(std::size_t offset) const noexcept
+{
+	std::size_t line;
+
+	if (offset >= m_starts.back()) // positions are mostly requested at the end of the consumed input
+		line = m_starts.size();
+	else
+		line = std::upper_bound(m_starts.begin(), m_starts.end(), offset) - m_starts.begin();
+
+	return { static_cast<int>(line), static_cast<int>(offset - m_starts[line - 1]) + 1 };
+}
+
+std::size_t line_index::size() const noexcept
+{
+	return m_starts.size();
+}
+
+std::size_t line_index::line_start(std::size_t line) const noexcept
+{
+	return m_starts[line - 1];
+}
@@ -1,21 +1,198 @@
+#include <chrono>
+#include <cstring>
 #include <iostream>
 #include <fstream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <system_error>
+#include <vector>
+#include "analyzer.hpp"
+#include "constant_folder.hpp"
+#include "evaluator.hpp"
+#include "mapped_file.hpp"
+#include "parser.hpp"
+#include "token_buffer.hpp"
+#include "token_pipeline.hpp"
 #include "tokenizer.hpp"
 
 int main(int argc, char** argv)
 {
-	if (argc < 2) {
+	const char* path = nullptr;
+	bool forceStream = false;
+	bool printStats = false;
+	std::size_t bufferSize = 65536;
+	unsigned threads = 1;
+	bool lint = false;
+	bool pipeline = false;
+	bool lazy = false;
+	bool generated = false;
+	bool check = false;
+	bool fold = false;
+	bool evaluate = false;
+
+	for (int i = 1; i < argc; ++i) {
+		if (std::strcmp(argv[i], "--stream") == 0)
+			forceStream = true;
+		else if (std::strcmp(argv[i], "--lint") == 0)
+			lint = true;
+		else if (std::strcmp(argv[i], "--pipeline") == 0)
+			pipeline = true;
+		else if (std::strcmp(argv[i], "--lazy") == 0)
+			lazy = true;
+		else if (std::strcmp(argv[i], "--generated") == 0)
+			generated = true;
+		else if (std::strcmp(argv[i], "--check") == 0)
+			check = true;
+		else if (std::strcmp(argv[i], "--fold") == 0)
+			check = fold = true;
+		else if (std::strcmp(argv[i], "--evaluate") == 0)
+			check = fold = evaluate = true;
+		else if (std::strcmp(argv[i], "--stats") == 0)
+			printStats = true;
+		else if (std::strcmp(argv[i], "--buffer-size") == 0 && i + 1 < argc)
+			bufferSize = std::stoul(argv[++i]);
+		else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+			threads = std::stoul(argv[++i]);
+		else
+			path = argv[i];
+	}
+
+	if (!path) {
 		std::cerr << "expected input file!\n";
 		return 1;
 	}
 
-	std::ifstream file(argv[1]);
-	cntlang::stream_info stream(file, argv[1]);
+	std::optional<cntlang::mapped_file> mapping;
+	std::ifstream file;
+	std::unique_ptr<cntlang::stream_info> stream;
+
+	try {
+		if (!forceStream) {
+			mapping.emplace(path);
+			stream = std::make_unique<cntlang::stream_info>(mapping->contents(), path);
+		}
+	} catch (const std::system_error&) { // not mappable (pipe, device), fall back to the istream path
+	}
+
+	if (!stream) {
+		file.open(path, std::ios::binary);
+
+		if (!file) {
+			std::cerr << "could not open " << path << "!\n";
+			return 1;
+		}
+
+		stream = std::make_unique<cntlang::stream_info>(file, path, bufferSize);
+	}
+
+	cntlang::interner symbols;
+	cntlang::type_table types;
+	auto start = std::chrono::steady_clock::now();
+
+	if (lint) {
+		std::vector<cntlang::lexical_diagnostic> diagnostics;
+		std::vector<cntlang::parser_diagnostic> errors;
+
+		diagnostics.reserve(256);
+
+		cntlang::token_buffer tokens = cntlang::tokenize(*stream, symbols, diagnostics);
+
+		cntlang::parser parser(tokens, symbols);
+		parser.parse(errors, lazy);
+
+		// both lists are in source order, report them merged
+		for (std::size_t lexical = 0, syntax = 0; lexical < diagnostics.size() || syntax < errors.size();) {
+			bool fromLexer = syntax == errors.size() || (lexical < diagnostics.size() && diagnostics[lexical].offset <= errors[syntax].offset);
+			auto [line, column] = stream->locate(fromLexer ? diagnostics[lexical].offset : errors[syntax].offset);
+
+			std::cerr << stream->source() << ':' << line << ':' << column << ": "
+				<< (fromLexer ? cntlang::lexical_error::describe(diagnostics[lexical++].error) : cntlang::parser_error::describe(errors[syntax++].error)) << '\n';
+		}
+
+		if (!diagnostics.empty() || !errors.empty())
+			return 1;
+
+		std::vector<cntlang::semantic_diagnostic> semantic;
+
+		// lazy bodies are parsed as analysis reaches them; their syntax errors come first, as the others did
+		cntlang::analyzer(parser, types, threads).analyze(errors, semantic);
+
+		for (const auto& error : errors) {
+			auto [line, column] = stream->locate(error.offset);
+			std::cerr << stream->source() << ':' << line << ':' << column << ": " << cntlang::parser_error::describe(error.error) << '\n';
+		}
+
+		if (!errors.empty())
+			return 1;
+
+		for (const auto& diagnostic : semantic) {
+			auto [line, column] = stream->locate(diagnostic.offset);
+			std::cerr << stream->source() << ':' << line << ':' << column << ": " << cntlang::semantic_error::describe(diagnostic.error) << '\n';
+		}
+
+		if (!semantic.empty())
+			return 1;
+	} else {
+		std::size_t nodes = 0;
+		std::uint32_t folded = 0;
+		cntlang::globals_image image;
+		auto run = [generated, lazy, check, fold, evaluate, threads, &types, &folded, &image](cntlang::parser&& parser) {
+			const cntlang::ast& tree = generated ? parser.parse_generated() : parser.parse(lazy);
+
+			if (check) {
+				cntlang::analyzer analyzer(parser, types, threads); // parses the lazy bodies the globals reach, the only ones evaluation runs
+
+				analyzer.analyze();
+
+				if (fold) {
+					cntlang::constant_folder constants(tree, parser.tokens(), analyzer);
+
+					folded = constants.fold();
+
+					if (evaluate)
+						image = cntlang::evaluator(tree, parser.tokens(), analyzer, types, constants).evaluate();
+				}
+			}
+
+			return tree.size();
+		};
+
+		try {
+			if (mapping && threads > 1) {
+				cntlang::token_buffer tokens = cntlang::tokenize_parallel(mapping->contents(), symbols, threads);
+				nodes = run(cntlang::parser(tokens, symbols, threads));
+			} else if (pipeline) {
+				cntlang::token_pipeline tokens(*stream, symbols);
+				nodes = run(cntlang::parser(tokens, symbols));
+			} else {
+				nodes = run(cntlang::parser(*stream, symbols));
+			}
+		} catch (const cntlang::lexical_error& error) {
+			std::cerr << stream->source() << ':' << error.line() << ':' << error.column() << ": " << error.what() << '\n';
+			return 1;
+		} catch (const cntlang::parser_error& error) {
+			std::cerr << stream->source() << ':' << error.line() << ':' << error.column() << ": " << error.what() << '\n';
+			return 1;
+		} catch (const cntlang::semantic_error& error) {
+			std::cerr << stream->source() << ':' << error.line() << ':' << error.column() << ": " << error.what() << '\n';
+			return 1;
+		}
+
+		if (printStats) {
+			std::cerr << stream->source() << ": " << nodes << " nodes" << (fold ? ", " + std::to_string(folded) + " folded away" : "") << '\n';
+
+			if (evaluate)
+				std::cerr << stream->source() << ": " << image.declarations.size() << " globals precomputed, " << image.pending.size() << " initialized at startup\n";
+		}
+	}
+
+	if (printStats) {
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
 
-	for (auto tkn = cntlang::next_token(stream);
-			tkn.type != cntlang::token::kind::end_of_stream;
-			tkn = cntlang::next_token(stream)) {
-//		std::cout << stream.source() << ':' << tkn << '\n';
+		std::cerr << stream->source() << ": " << stream->bytes_read() << " bytes, "
+			<< stream->refills() << " refills, "
+			<< stream->bytes_read() / elapsed.count() / (1024 * 1024) << " MiB/s\n";
 	}
 
 	return 0;
@@ -0,0 +1,94 @@
+#include <cerrno>
+#include <system_error>
+#include <utility>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "mapped_file.hpp"
+
+using namespace cntlang;
+
+mapped_file::mapped_file(const std::string& path)
+{
+	int fd = ::open(path.c_str(), O_RDONLY);
+
+	if (fd < 0)
+		throw std::system_error(errno, std::generic_category(), path);
+
+	struct stat info;
+
+	if (::fstat(fd, &info) < 0) {
+		int error = errno;
+		::close(fd);
+		throw std::system_error(error, std::generic_category(), path);
+	}
+
+	if (!S_ISREG(info.st_mode)) { // pipes, sockets, devices: use the istream path instead
+		::close(fd);
+		throw std::system_error(std::make_error_code(std::errc::not_supported), path);
+	}
+
+	m_size = static_cast<std::size_t>(info.st_size);
+
+	if (m_size > 0) {
+		void* address = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+		if (address == MAP_FAILED) {
+			int error = errno;
+			::close(fd);
+			throw std::system_error(error, std::generic_category(), path);
+		}
+
+		::madvise(address, m_size, MADV_SEQUENTIAL);
+		m_data = static_cast<const char*>(address);
+	}
+
+	::close(fd);
+}
+
+mapped_file::mapped_file(mapped_file&& other) noexcept
+: m_data(std::exchange(other.m_data, nullptr))
+, m_size(std::exchange(other.m_size, 0))
+{
+}
+
+mapped_file::~mapped_file()
+{
+	unmap();
+}
+
+mapped_file& mapped_file::operator=(mapped_file&& other) noexcept
+{
+	if (this != &other) {
+		unmap();
+		m_data = std::exchange(other.m_data, nullptr);
+		m_size = std::exchange(other.m_size, 0);
+	}
+
+	return *this;
+}
+
+const char* mapped_file::data() const noexcept
+{
+	return m_data;
+}
+
+std::size_t mapped_file::size() const noexcept
+{
+	return m_size;
+}
+
+std::string_view mapped_file::contents() const noexcept
+{
+	return std::string_view(m_data, m_size);
+}
+
+void mapped_file::unmap() noexcept
+{
+	if (m_data)
+		::munmap(const_cast<char*>(m_data), m_size);
+
+	m_data = nullptr;
+	m_size = 0;
+}
@@ -1,5 +1,10 @@
+#include <algorithm>
+#include <exception>
+#include <memory>
+#include <thread>
 #include "parser.hpp"
 #include "tokenizer.hpp"
+#include "work_stealing.hpp"
 
 namespace cntlang
 {
@@ -10,6 +15,34 @@ namespace cntlang
 	{
 	}
 
+	const char* parser_error::describe(kind error) noexcept
+	{
+		switch (error) {
+		case kind::global_expected: return "expected variable or function definition";
+		case kind::expected_identifier: return "expected identifier";
+		case kind::expected_type: return "expected type";
+		case kind::expected_expression: return "expected expression";
+		case kind::expected_colon: return "expected ':'";
+		case kind::expected_semicolon: return "expected ';'";
+		case kind::expected_delimiter: return "expected ','";
+		case kind::expected_assign: return "expected '='";
+		case kind::expected_parenthesis_left: return "expected '('";
+		case kind::expected_parenthesis_right: return "expected ')'";
+		case kind::expected_let: return "expected 'let'";
+		case kind::expected_then: return "expected 'then'";
+		case kind::expected_do: return "expected 'do'";
+		case kind::expected_end: return "expected 'end'";
+		case kind::duplicate_declaration: return "name already declared in this scope";
+		}
+
+		return "syntax error";
+	}
+
+	const char* parser_error::what() const noexcept
+	{
+		return describe(m_error);
+	}
+
 	parser_error::kind parser_error::error() const noexcept
 	{
 		return m_error;
@@ -28,61 +61,1344 @@ namespace cntlang
 
 namespace cntlang
 {
-	using tree_type = typename node::tree_type;
+	struct binding
+	{
+		int precedence; // 0 for tokens that are not binary operators
+		typename node::kind type;
+		bool right; // associativity
+	};
+
+	constexpr binding binding_of(typename token::kind kind) noexcept
+	{
+		switch (kind) {
+		case token::kind::assign:
+		case token::kind::assign_add:
+		case token::kind::assign_subtract:
+		case token::kind::assign_multiply:
+		case token::kind::assign_divide:
+		case token::kind::assign_remainder:
+			return { 1, node::kind::assignment_expression, true };
+		case token::kind::logical_and:
+		case token::kind::logical_or:
+			return { 2, node::kind::logical_expression, false };
+		case token::kind::equal:
+		case token::kind::not_equal:
+		case token::kind::less:
+		case token::kind::less_or_equal:
+		case token::kind::greater:
+		case token::kind::greater_or_equal:
+			return { 3, node::kind::relational_expression, false };
+		case token::kind::add:
+		case token::kind::subtract:
+			return { 4, node::kind::additive_expression, false };
+		case token::kind::multiply:
+		case token::kind::divide:
+		case token::kind::remainder:
+			return { 5, node::kind::multiplicative_expression, false };
+		default:
+			return { 0, node::kind::dummy, false };
+		}
+	}
+
+	// Token index of every top-level definition from first on, matching fn/if/while/for with end. Empty when the
+	// definitions do not tile the buffer cleanly; the serial parser then finds and reports the problem.
+	std::vector<std::uint32_t> split_definitions(const token_buffer& tokens, std::uint32_t first)
+	{
+		std::vector<std::uint32_t> starts;
+		std::uint32_t index = first;
+
+		for (;;) {
+			while (tokens.type(index) == token::kind::comment)
+				++index;
+
+			typename token::kind type = tokens.type(index);
+
+			if (type == token::kind::end_of_stream)
+				return starts;
+
+			starts.push_back(index++);
+
+			if (type == token::kind::keyword_let) {
+				for (; tokens.type(index) != token::kind::semicolon; ++index) {
+					if (tokens.type(index) == token::kind::end_of_stream || tokens.type(index) == token::kind::keyword_fn)
+						return {};
+				}
+			} else if (type == token::kind::keyword_fn) {
+				for (std::uint32_t depth = 1; depth > 0; ++index) {
+					switch (tokens.type(index)) {
+					case token::kind::keyword_fn:
+					case token::kind::keyword_if:
+					case token::kind::keyword_while:
+					case token::kind::keyword_for:
+						++depth;
+						break;
+					case token::kind::keyword_end:
+						--depth;
+						break;
+					case token::kind::end_of_stream:
+						return {};
+					default:
+						break;
+					}
+				}
+
+				--index;
+			} else {
+				return {};
+			}
+
+			++index; // past ; or end
+		}
+	}
+
+	constexpr bool ends_block(typename token::kind kind) noexcept
+	{
+		return kind == token::kind::keyword_end || kind == token::kind::keyword_elseif
+			|| kind == token::kind::keyword_else || kind == token::kind::end_of_stream;
+	}
+
+	// Where a statement list picks up again after an error: past a ';', or at a keyword that ends the list or
+	// starts a statement or definition of its own.
+	constexpr bool resumes_statement(typename token::kind kind) noexcept
+	{
+		switch (kind) {
+		case token::kind::semicolon:
+		case token::kind::keyword_fn:
+		case token::kind::keyword_let:
+		case token::kind::keyword_return:
+		case token::kind::keyword_if:
+		case token::kind::keyword_while:
+		case token::kind::keyword_for:
+		case token::kind::keyword_break:
+		case token::kind::keyword_continue:
+			return true;
+		default:
+			return ends_block(kind);
+		}
+	}
+
+	parser::parser(stream_info& stream, interner& symbols)
+	: m_stream(&stream)
+	, m_symbols(symbols)
+	{
+	}
+
+	parser::parser(const token_buffer& tokens, interner& symbols, unsigned threads)
+	: m_tokens(&tokens)
+	, m_threads(threads)
+	, m_symbols(symbols)
+	{
+	}
+
+	parser::parser(const token_buffer& tokens, interner& symbols, std::uint32_t first, std::uint32_t last)
+	: m_tokens(&tokens)
+	, m_index(first)
+	, m_last(last)
+	, m_symbols(symbols)
+	{
+	}
+
+	parser::parser(token_pipeline& pipeline, interner& symbols)
+	: m_pipeline(&pipeline)
+	, m_symbols(symbols)
+	{
+	}
+
+	const ast& parser::parse(bool lazy)
+	{
+		m_lazy = lazy;
+		m_panic = false;
+		m_partial = false;
+		m_tree.reserve(m_tokens ? m_tokens->size() : 4096);
+
+		try {
+			scan();
+			m_tree.set_root(m_tokens && m_threads > 1 ? parse_program_parallel() : parse_program());
+		} catch (...) { // the tree is half built, the next reparse starts over
+			m_partial = true;
+			throw;
+		}
+
+		m_compacted = m_tree.size();
+
+		keep_scanned();
+
+		return m_tree;
+	}
+
+	const ast& parser::parse(std::vector<parser_diagnostic>& diagnostics, bool lazy)
+	{
+		m_diagnostics = &diagnostics;
+
+		try {
+			parse(lazy);
+		} catch (...) { // lexical errors of a streamed source still end the parse
+			m_diagnostics = nullptr;
+			throw;
+		}
+
+		m_diagnostics = nullptr; // parse_body and reparse throw again
+		return m_tree;
+	}
+
+	std::uint32_t parser::parse_body(std::uint32_t definition)
+	{
+		std::uint32_t body = m_tree.child(definition, 2);
+
+		if (m_tree[body].type != node::kind::lazy_body)
+			return body;
+
+		std::uint32_t parameters = m_tree.child(definition, 0);
+		std::uint32_t depth = m_scopes.depth(); // just the globals
+
+		m_index = m_tree.token(body);
+		m_unresolved.clear();
+		m_panic = false;
+
+		try {
+			scan();
+			m_scopes.push_scope();
+
+			for (std::uint32_t index = 0; index < m_tree[parameters].count; ++index)
+				declare(m_tree.child(parameters, index));
+
+			body = parse_statement_list();
+
+			// a stray else or elseif ends the list early, as when parsed eagerly; an unclosed body was reported then
+			if (m_token.type == token::kind::keyword_else || m_token.type == token::kind::keyword_elseif)
+				fail(parser_error::kind::expected_end);
+		} catch (...) {
+			while (m_scopes.depth() > depth)
+				m_scopes.pop_scope();
+
+			m_pending.clear();
+			throw;
+		}
+
+		m_scopes.pop_scope();
+		resolve_globals();
+		m_tree.set_child(definition, 2, body);
+
+		return body;
+	}
+
+	std::uint32_t parser::parse_body(std::uint32_t definition, std::vector<parser_diagnostic>& diagnostics)
+	{
+		auto mark = static_cast<std::ptrdiff_t>(diagnostics.size());
+		std::uint32_t body = ast::dummy;
+
+		m_diagnostics = &diagnostics;
+
+		try {
+			body = parse_body(definition);
+		} catch (...) {
+			m_diagnostics = nullptr;
+			throw;
+		}
+
+		m_diagnostics = nullptr;
+
+		// bodies may be parsed in any order, their errors go between those found before
+		std::inplace_merge(diagnostics.begin(), diagnostics.begin() + mark, diagnostics.end(), [](const parser_diagnostic& left, const parser_diagnostic& right) {
+			return left.offset < right.offset;
+		});
+
+		return body;
+	}
+
+	void parser::parse_bodies()
+	{
+		std::uint32_t root = m_tree.root();
+
+		for (std::uint32_t nth = 0; nth < m_tree[root].count; ++nth) {
+			std::uint32_t definition = m_tree.child(root, nth);
+
+			if (m_tree[definition].type == node::kind::function_definition)
+				parse_body(definition);
+		}
+	}
+
+	void parser::parse_bodies(std::vector<parser_diagnostic>& diagnostics)
+	{
+		auto mark = static_cast<std::ptrdiff_t>(diagnostics.size());
+
+		m_diagnostics = &diagnostics;
+
+		try {
+			parse_bodies();
+		} catch (...) {
+			m_diagnostics = nullptr;
+			throw;
+		}
+
+		m_diagnostics = nullptr;
+
+		// the bodies' errors were found after the definitions', but go between them
+		std::inplace_merge(diagnostics.begin(), diagnostics.begin() + mark, diagnostics.end(), [](const parser_diagnostic& left, const parser_diagnostic& right) {
+			return left.offset < right.offset;
+		});
+	}
+
+	std::uint32_t parser::reparse(const token_change& change)
+	{
+		std::uint32_t editFirst = change.first;
+		std::uint32_t editLast = change.first + change.inserted; // the new tokens are [editFirst, editLast)
+		std::uint32_t root = m_tree.root();
+		std::uint32_t count = m_tree[root].count;
+		const std::uint32_t* definitions = m_tree.children(root);
+
+		m_tree.shift_tokens(change.first, change.removed, change.inserted);
+
+		if (m_partial) // error nodes do not say where their tokens ended
+			return parse_again();
+
+		// starts ascend; a stale one was inside the edit, so it sorts after editFirst too
+		auto nth = static_cast<std::uint32_t>(std::partition_point(definitions, definitions + count, [this, editFirst](std::uint32_t definition) {
+			return definition_start(definition) < editFirst;
+		}) - definitions);
+
+		if (nth == 0)
+			return parse_again();
+
+		std::uint32_t definition = m_tree.child(root, nth - 1);
+		std::uint32_t last = nth < count ? definition_start(m_tree.child(root, nth)) : node::no_token; // where the next definition starts
+
+		if (last < editLast || last == node::stale_token)
+			return parse_again();
+
+		try {
+			if (m_tree[definition].type == node::kind::function_definition) {
+				std::uint32_t body = m_tree.child(definition, 2);
+				std::uint32_t terminator = last_before(nth < count ? last : m_tokens->size() - 1); // end of the function
+
+				if (m_tree[body].type == node::kind::statement_list && m_tree.token(body) < editFirst && terminator >= editLast)
+					return collect(reparse_list(change, definition, terminator));
+			}
+
+			return collect(reparse_definition(definition, last));
+		} catch (const parser_error&) { // reported by the full parse, at the same place as a fresh parse
+		} catch (...) { // a lexical error, scopes and tree are left mid-parse
+			m_partial = true;
+			throw;
+		}
+
+		return parse_again();
+	}
+
+	std::uint32_t parser::parse_again()
+	{
+		m_tree.clear();
+		m_scopes = symbol_table();
+		m_unresolved.clear();
+		m_pending.clear();
+		m_index = 0;
+		m_last = ~std::uint32_t(0);
+
+		return parse(m_lazy).root();
+	}
 
-	void scan(stream_info& stream, token& current);
-	void expect(stream_info& stream, token& current, typename token::kind kind, typename parser_error::kind error);
+	std::uint32_t parser::collect(std::uint32_t kept)
+	{
+		if (m_tree.size() <= 2 * m_compacted) // what reparses orphaned does not outnumber the rest yet
+			return kept;
 
-	node parse_program(stream_info& stream, token& current);
-	node parse_variable_definition(stream_info& stream, token& current);
-	node parse_function_definition(stream_info& stream, token& current);
-	node parse_statement(stream_info& stream)
+		std::vector<std::uint32_t> remap = m_tree.compact();
 
-	void parse_type(stream_info& stream, token& current, node& node);
-	void parse_declaration(stream_info& stream, token& current, node& node);
+		m_scopes.renumber(remap);
+		m_unresolved.clear();
+		m_compacted = m_tree.size();
 
-	node parse(stream_info& stream)
+		return remap[kept];
+	}
+
+	std::uint32_t parser::reparse_definition(std::uint32_t definition, std::uint32_t last)
 	{
-		token current;
+		std::size_t mark = m_pending.size();
+		std::uint32_t firstNode = m_tree.size();
+
+		m_index = definition_start(definition);
+		m_last = last;
+		m_unresolved.clear();
+		scan();
+		m_scopes.push_scope(); // the old definition is still among the globals
+		parse_definitions();
+		m_scopes.pop_scope();
+		m_last = ~std::uint32_t(0);
+
+		if (m_pending.size() != mark + 1 || (last != node::no_token && m_token_index != last))
+			return parse_again();
+
+		std::uint32_t replacement = m_pending.back();
+		bool variable = m_tree[definition].type == node::kind::variable_definition;
+		std::uint32_t declaration = variable ? m_tree.child(definition, 0) : definition;
+		std::uint32_t redeclaration = variable ? m_tree.child(replacement, 0) : replacement;
+
+		m_pending.resize(mark);
+
+		if (m_tree[replacement].type != m_tree[definition].type || m_scopes.lookup(tokens()[m_tree.token(redeclaration)].symbol) != declaration)
+			return parse_again(); // renamed, other uses may resolve differently
+
+		resolve_globals();
+
+		if (variable) { // keep the old indices so bindings elsewhere stay valid
+			m_tree.replace(declaration, redeclaration);
+			m_tree.set_child(replacement, 0, declaration);
+			m_tree.rebind(redeclaration, declaration, firstNode);
+		}
 
-		scan(stream, current);
-		return parse_program(stream, current);
+		m_tree.replace(definition, replacement);
+		m_tree.rebind(replacement, definition, firstNode);
+
+		return definition;
 	}
 
-	void scan(stream_info& stream, token& current)
+	std::uint32_t parser::reparse_list(const token_change& change, std::uint32_t definition, std::uint32_t terminator)
 	{
-		current = next_token(stream);
+		std::uint32_t editFirst = change.first;
+		std::uint32_t editLast = change.first + change.inserted;
+		std::uint32_t depth = m_scopes.depth();
+		std::uint32_t parameters = m_tree.child(definition, 0);
+		std::uint32_t parent = definition;
+		std::uint32_t nth = 2;
+
+		m_scopes.push_scope();
+
+		for (std::uint32_t index = 0; index < m_tree[parameters].count; ++index)
+			declare(m_tree.child(parameters, index));
+
+		for (;;) { // narrow down to the innermost list holding the edit, declaring what is visible there
+			std::uint32_t list = m_tree.child(parent, nth);
+			std::uint32_t count = m_tree[list].count;
+			std::uint32_t k = 0;
+
+			while (k < count && statement_start(m_tree.child(list, k)) < editFirst)
+				++k;
+
+			if (k == 0)
+				break;
+
+			std::uint32_t statement = m_tree.child(list, k - 1);
+			std::uint32_t next = k < count ? statement_start(m_tree.child(list, k)) : terminator;
+
+			if (next == node::stale_token || next < editLast)
+				break;
+
+			std::uint32_t end = last_before(next); // of the statement
+			std::uint32_t innerParent = ast::dummy;
+			std::uint32_t innerNth = 0;
+			std::uint32_t innerTerminator = end;
+
+			switch (m_tree[statement].type) {
+			case node::kind::while_statement:
+				innerParent = statement;
+				innerNth = 1;
+				break;
+			case node::kind::for_statement:
+				innerParent = statement;
+				innerNth = 4;
+				break;
+			case node::kind::if_statement: // then list, then each elseif/else branch ends where the next begins
+				for (std::uint32_t branch = 0; branch + 1 < m_tree[statement].count; ++branch) {
+					std::uint32_t holder = branch == 0 ? statement : m_tree.child(statement, branch + 1);
+					std::uint32_t position = branch == 0 ? 1 : m_tree[holder].count - 1;
+					std::uint32_t following = branch + 2 < m_tree[statement].count ? m_tree.token(m_tree.child(statement, branch + 2)) : end;
+
+					if (m_tree.token(m_tree.child(holder, position)) < editFirst && following != node::stale_token && following >= editLast) {
+						innerParent = holder;
+						innerNth = position;
+						innerTerminator = following;
+					}
+				}
+				break;
+			default:
+				break;
+			}
+
+			if (innerParent == ast::dummy || m_tree.token(m_tree.child(innerParent, innerNth)) >= editFirst || innerTerminator < editLast)
+				break;
+
+			m_scopes.push_scope();
+
+			for (std::uint32_t index = 0; index + 1 < k; ++index) {
+				if (m_tree[m_tree.child(list, index)].type == node::kind::variable_definition)
+					declare(m_tree.child(m_tree.child(list, index), 0));
+			}
+
+			if (m_tree[statement].type == node::kind::for_statement) {
+				m_scopes.push_scope();
+				declare(m_tree.child(statement, 0));
+			}
+
+			parent = innerParent;
+			nth = innerNth;
+			terminator = innerTerminator;
+		}
+
+		m_index = m_tree.token(m_tree.child(parent, nth));
+		m_unresolved.clear();
+		scan();
+
+		std::uint32_t replacement = parse_statement_list();
+
+		if (m_token_index != terminator)
+			return parse_again();
+
+		while (m_scopes.depth() > depth)
+			m_scopes.pop_scope();
+
+		resolve_globals();
+		m_tree.set_child(parent, nth, replacement);
+
+		return replacement;
 	}
 
-	void expect(stream_info& stream, token& current, typename token::kind kind, typename parser_error::kind error)
+	std::uint32_t parser::statement_start(std::uint32_t statement) const noexcept
 	{
-		scan(stream, current);
+		switch (m_tree[statement].type) {
+		case node::kind::variable_definition:
+		case node::kind::return_stmt:
+		case node::kind::if_statement:
+		case node::kind::while_statement:
+		case node::kind::for_statement:
+		case node::kind::break_statement:
+		case node::kind::continue_statement:
+			return m_tree.token(statement); // the keyword
+		default:
+			break;
+		}
+
+		std::uint32_t current = statement;
+
+		for (;;) {
+			switch (m_tree[current].type) {
+			case node::kind::assignment_expression:
+			case node::kind::logical_expression:
+			case node::kind::relational_expression:
+			case node::kind::additive_expression:
+			case node::kind::multiplicative_expression:
+				current = m_tree.child(current, 0); // the left operand comes first
+				continue;
+			default:
+				break;
+			}
+
+			break;
+		}
 
-		if (current.type != kind)
-			throw parser_error(error, current.line, current.column);
+		std::uint32_t start = m_tree.token(current);
+
+		if (start >= node::stale_token)
+			return start;
+
+		for (std::uint32_t index = start; index > 0;) { // parentheses around the left operand
+			typename token::kind type = m_tokens->type(--index);
+
+			if (type == token::kind::parenthesis_left)
+				start = index;
+			else if (type != token::kind::comment)
+				break;
+		}
+
+		return start;
 	}
 
-	node parse_program(stream_info& stream, token& current)
+	std::uint32_t parser::definition_start(std::uint32_t definition) const noexcept
 	{
-		node program(node::kind::program, tree_type());
+		std::uint32_t start = m_tree.token(definition);
+
+		if (start >= node::stale_token || m_tree[definition].type == node::kind::variable_definition)
+			return start;
 
-		while (current.type != token::kind::end_of_stream) {
-			if (current.type == token::kind::keyword_let)
-				program.append(parse_variable_definition(stream, current));
-			else if (current.type == token::kind::keyword_fn)
-				program.append(parse_function_definition(stream, current));
-			else
-				throw parser_error(parser_error::kind::global_expected, current.line, current.column);
+		return last_before(start); // fn before the name
+	}
+
+	std::uint32_t parser::last_before(std::uint32_t index) const noexcept
+	{
+		do {
+			--index;
+		} while (index > 0 && m_tokens->type(index) == token::kind::comment);
+
+		return index;
+	}
+
+	void parser::keep_scanned()
+	{
+		if (m_tokens)
+			return;
+
+		// from here on walk the kept tokens, lazy bodies are parsed from them
+		m_scanned.lines() = m_stream ? m_stream->lines() : m_pipeline->lines();
+		m_tokens = &m_scanned;
+		m_stream = nullptr;
+		m_pipeline = nullptr;
+	}
+
+	const ast& parser::tree() const noexcept
+	{
+		return m_tree;
+	}
+
+	const token_buffer& parser::tokens() const noexcept
+	{
+		return m_tokens ? *m_tokens : m_scanned;
+	}
+
+	void parser::scan()
+	{
+		do {
+			if (m_tokens) {
+				m_token_index = m_index < m_tokens->size() - 1 ? m_index++ : m_index;
+			} else {
+				// lexed on demand and kept, so nodes can refer to tokens by index
+				if (m_scanned.size() == 0 || m_scanned.type(m_scanned.size() - 1) != token::kind::end_of_stream)
+					m_scanned.push(m_pipeline ? m_pipeline->next() : next_token(*m_stream, m_symbols));
+
+				m_token_index = m_scanned.size() - 1;
+			}
+
+			m_token = tokens()[m_token_index];
+		} while (m_token.type == token::kind::comment);
+	}
+
+	void parser::expect(typename token::kind kind, typename parser_error::kind error)
+	{
+		if (m_panic)
+			return;
+
+		scan();
+
+		if (m_token.type != kind)
+			fail(error);
+	}
+
+	void parser::consume(typename token::kind kind, typename parser_error::kind error)
+	{
+		if (m_panic)
+			return;
+
+		if (m_token.type != kind)
+			fail(error);
+		else
+			scan();
+	}
+
+	void parser::fail(typename parser_error::kind error)
+	{
+		if (m_token.type == token::kind::error)
+			error_token();
+		else if (!m_panic) // the rest is fallout
+			report(error, m_token.offset);
+
+		m_partial = true;
+
+		m_panic = true;
+	}
+
+	void parser::error_token()
+	{
+		if (!m_diagnostics) { // relex left it in the buffer, it ends the parse as the lexer would have
+			auto [line, column] = tokens().lines().locate(m_token.offset);
+			throw lexical_error(static_cast<typename lexical_error::kind>(m_token.symbol), line, column);
 		}
 
-		return program;
+		m_partial = true; // the lexer reported it
+	}
+
+	void parser::report(typename parser_error::kind error, std::uint32_t offset)
+	{
+		if (!m_diagnostics)
+			raise(error, offset);
+
+		m_diagnostics->push_back({ error, offset });
+		m_partial = true;
+	}
+
+	void parser::raise(typename parser_error::kind error, std::uint32_t offset)
+	{
+		position where;
+
+		if (m_tokens)
+			where = m_tokens->lines().locate(offset);
+		else if (m_pipeline)
+			where = m_pipeline->locate(offset);
+		else
+			where = m_stream->locate(offset);
+
+		auto [line, column] = where;
+		throw parser_error(error, line, column);
 	}
 
-	node parse_variable_definition(stream_info& stream, token& current)
+	void parser::synchronize()
 	{
-		node definition(node::kind::variable_definition, tree_type());
+		while (!resumes_statement(m_token.type))
+			scan();
+
+		if (m_token.type == token::kind::semicolon)
+			scan();
+
+		m_panic = false;
+	}
+
+	void parser::synchronize_definitions()
+	{
+		while (m_token.type != token::kind::keyword_let && m_token.type != token::kind::keyword_fn
+			&& m_token.type != token::kind::end_of_stream && m_token_index < m_last)
+			scan();
+
+		m_panic = false;
+	}
+
+	void parser::skip_block()
+	{
+		// through the end matching a block whose header failed; a fn can only start the next definition
+		for (std::uint32_t depth = 0;; scan()) {
+			switch (m_token.type) {
+			case token::kind::keyword_if:
+			case token::kind::keyword_while:
+			case token::kind::keyword_for:
+				++depth;
+				break;
+			case token::kind::keyword_end:
+				if (depth == 0) {
+					scan();
+					m_panic = false;
+					return;
+				}
+
+				--depth;
+				break;
+			case token::kind::keyword_fn:
+			case token::kind::end_of_stream:
+				return;
+			default:
+				break;
+			}
+		}
+	}
+
+	std::uint32_t parser::abandon(std::uint32_t keyword, std::size_t mark)
+	{
+		m_pending.resize(mark);
+		skip_block();
+		return m_tree.add(node::kind::error, keyword);
+	}
+
+	std::uint32_t parser::leaf(typename node::kind type)
+	{
+		return m_tree.add(type, m_token_index);
+	}
+
+	std::uint32_t parser::close(typename node::kind type, std::uint32_t token, std::size_t mark)
+	{
+		std::uint32_t index = m_tree.add(type, token, m_pending.data() + mark, static_cast<std::uint32_t>(m_pending.size() - mark));
+
+		m_pending.resize(mark);
+		return index;
+	}
+
+	void parser::close(std::uint32_t index, std::size_t mark)
+	{
+		m_tree.set_children(index, m_pending.data() + mark, static_cast<std::uint32_t>(m_pending.size() - mark));
+		m_pending.resize(mark);
+	}
+
+	void parser::declare(std::uint32_t declaration)
+	{
+		std::uint32_t name = m_tree.token(declaration);
+
+		if (tokens().type(name) != token::kind::identifier) // recovered from a missing name
+			return;
+
+		if (!m_scopes.declare(tokens()[name].symbol, declaration) && !m_panic) // declared after a broken initializer
+			report(parser_error::kind::duplicate_declaration, tokens().offset(name));
+	}
+
+	void parser::resolve(std::uint32_t use, std::uint32_t name)
+	{
+		std::uint32_t symbol = tokens()[name].symbol;
+		std::uint32_t declaration = m_scopes.lookup(symbol);
+
+		if (declaration != symbol_table::not_found)
+			m_tree.bind(use, declaration);
+		else
+			m_unresolved.emplace_back(use, symbol);
+	}
+
+	std::uint32_t parser::parse_program()
+	{
+		std::size_t mark = m_pending.size();
+
+		m_scopes.push_scope(); // globals
+		parse_definitions();
+		resolve_globals();
+
+		return close(node::kind::program, node::no_token, mark);
+	}
+
+	std::uint32_t parser::parse_program_parallel()
+	{
+		auto groups = static_cast<unsigned>(std::min<std::size_t>(usable_threads(m_threads), m_tokens->size() / min_group_tokens));
+
+		if (groups < 2) // before the split, which is wasted on a serial parse
+			return parse_program();
+
+		std::vector<std::uint32_t> starts = split_definitions(*m_tokens, m_token_index);
+
+		groups = static_cast<unsigned>(std::min<std::size_t>(groups, starts.size()));
+
+		if (groups < 2)
+			return parse_program();
+
+		std::vector<std::uint32_t> bounds{ starts.front() }; // group i covers [bounds[i], bounds[i + 1])
+		std::uint32_t total = m_tokens->size() - starts.front();
+
+		for (std::size_t index = 1; index < starts.size() && bounds.size() < groups; ++index) {
+			if (starts[index] - starts.front() >= std::uint64_t(total) * bounds.size() / groups)
+				bounds.push_back(starts[index]);
+		}
+
+		bounds.push_back(m_tokens->size());
+
+		std::vector<std::unique_ptr<parser>> workers;
+		std::vector<std::exception_ptr> errors(bounds.size() - 1);
+		std::vector<std::vector<parser_diagnostic>> diagnostics(bounds.size() - 1);
+		std::vector<std::thread> threads;
+
+		for (std::size_t index = 0; index + 1 < bounds.size(); ++index) {
+			workers.push_back(std::unique_ptr<parser>(new parser(*m_tokens, m_symbols, bounds[index], bounds[index + 1])));
+			workers.back()->m_lazy = m_lazy;
+			workers.back()->m_tree.reserve(bounds[index + 1] - bounds[index]); // a node per token at most, as in parse()
+
+			if (m_diagnostics)
+				workers.back()->m_diagnostics = &diagnostics[index];
+		}
+
+		for (std::size_t index = 1; index < workers.size(); ++index) {
+			threads.emplace_back([&workers, &errors, index]() {
+				try {
+					workers[index]->scan();
+					workers[index]->m_scopes.push_scope();
+					workers[index]->parse_definitions();
+				} catch (...) {
+					errors[index] = std::current_exception();
+				}
+			});
+		}
+
+		try {
+			workers.front()->scan();
+			workers.front()->m_scopes.push_scope();
+			workers.front()->parse_definitions();
+		} catch (...) {
+			errors.front() = std::current_exception();
+		}
+
+		for (auto& thread : threads)
+			thread.join();
+
+		for (std::size_t index = 0; index < errors.size(); ++index) {
+			if (errors[index] || !diagnostics[index].empty()) // reparse serially so errors come in source order
+				return parse_program();
+		}
+
+		// the tree is sized once and each worker's nodes are copied in on a thread of their own, so no single
+		// thread faults in all of it
+		std::vector<std::pair<std::uint32_t, std::uint32_t>> bases;
+
+		for (const auto& worker : workers)
+			bases.push_back(m_tree.grow(worker->m_tree));
+
+		threads.clear();
+
+		for (std::size_t index = 1; index < workers.size(); ++index)
+			threads.emplace_back([this, &workers, &bases, index]() { m_tree.splice(workers[index]->m_tree, bases[index]); });
+
+		m_tree.splice(workers.front()->m_tree, bases.front());
+
+		for (auto& thread : threads)
+			thread.join();
+
+		std::size_t mark = m_pending.size();
+
+		m_scopes.push_scope(); // globals
+
+		for (std::size_t index = 0; index < workers.size(); ++index) {
+			const parser& worker = *workers[index];
+			std::uint32_t base = bases[index].first;
+
+			for (std::uint32_t definition : worker.m_pending) {
+				m_pending.push_back(definition + base);
+				declare_definition(definition + base);
+			}
+
+			for (auto [use, symbol] : worker.m_unresolved) {
+				if (worker.m_tree.binding(use) == ast::dummy)
+					m_unresolved.emplace_back(use + base, symbol);
+			}
+		}
+
+		resolve_globals();
+		return close(node::kind::program, node::no_token, mark);
+	}
+
+	void parser::parse_definitions()
+	{
+		while (m_token.type != token::kind::end_of_stream && m_token_index < m_last) {
+			if (m_token.type == token::kind::keyword_let)
+				m_pending.push_back(parse_variable_definition());
+			else if (m_token.type == token::kind::keyword_fn)
+				m_pending.push_back(parse_function_definition());
+			else {
+				fail(parser_error::kind::global_expected);
+				m_pending.push_back(leaf(node::kind::error));
+			}
+
+			if (m_panic)
+				synchronize_definitions();
+		}
+	}
+
+	void parser::declare_definition(std::uint32_t definition)
+	{
+		declare(m_tree[definition].type == node::kind::variable_definition ? m_tree.child(definition, 0) : definition);
+	}
+
+	void parser::resolve_globals()
+	{
+		for (auto [use, symbol] : m_unresolved) { // only globals are left in scope
+			std::uint32_t declaration = m_scopes.lookup(symbol);
+
+			if (declaration != symbol_table::not_found)
+				m_tree.bind(use, declaration);
+		}
+	}
+
+	std::uint32_t parser::parse_variable_definition()
+	{
+		std::size_t mark = m_pending.size();
+		std::uint32_t let = m_token_index;
+
+		scan(); // skip let
+
+		std::uint32_t declaration = parse_declaration();
+
+		m_pending.push_back(declaration);
+
+		if (m_token.type == token::kind::assign) {
+			scan();
+			m_pending.push_back(parse_expression());
+		} else {
+			m_pending.push_back(ast::dummy);
+		}
+
+		declare(declaration); // not visible in its own initializer
+		consume(token::kind::semicolon, parser_error::kind::expected_semicolon);
+		return close(node::kind::variable_definition, let, mark);
+	}
+
+	std::uint32_t parser::parse_function_definition()
+	{
+		std::size_t mark = m_pending.size();
+
+		expect(token::kind::identifier, parser_error::kind::expected_identifier);
+
+		std::uint32_t definition = leaf(node::kind::function_definition); // children come later, the body may call it
+
+		declare(definition);
+		expect(token::kind::parenthesis_left, parser_error::kind::expected_parenthesis_left);
+
+		std::size_t parameters = m_pending.size();
+		std::uint32_t parenthesis = m_token_index;
+
+		m_scopes.push_scope();
+		scan();
+
+		if (m_token.type != token::kind::parenthesis_right) {
+			for (;;) {
+				m_pending.push_back(parse_declaration());
+				declare(m_pending.back());
+
+				if (m_token.type != token::kind::delimiter)
+					break;
+
+				scan(); // skip ,
+			}
+		}
+
+		m_pending.push_back(close(node::kind::declaration_list, parenthesis, parameters));
+		consume(token::kind::parenthesis_right, parser_error::kind::expected_parenthesis_right);
+		consume(token::kind::colon, parser_error::kind::expected_colon);
+		m_pending.push_back(parse_type(false));
+
+		if (m_panic) { // the body goes with a broken header
+			m_pending.push_back(ast::dummy);
+			skip_block();
+		} else {
+			m_pending.push_back(m_lazy ? skip_statement_list() : parse_statement_list());
+			consume(token::kind::keyword_end, parser_error::kind::expected_end);
+		}
+
+		m_scopes.pop_scope();
+		close(definition, mark);
+
+		return definition;
+	}
+
+	std::uint32_t parser::parse_statement_list()
+	{
+		std::size_t mark = m_pending.size();
+		std::uint32_t first = m_token_index;
+
+		m_scopes.push_scope();
+
+		while (!ends_block(m_token.type) && m_token.type != token::kind::keyword_fn) { // fn: this body was never closed
+			m_pending.push_back(parse_statement());
+
+			if (m_panic)
+				synchronize();
+		}
+
+		m_scopes.pop_scope();
+		return close(node::kind::statement_list, first, mark);
+	}
+
+	std::uint32_t parser::skip_statement_list()
+	{
+		std::uint32_t body = leaf(node::kind::lazy_body);
+
+		for (std::uint32_t depth = 0; depth > 0 || m_token.type != token::kind::keyword_end; scan()) {
+			switch (m_token.type) {
+			case token::kind::keyword_if:
+			case token::kind::keyword_while:
+			case token::kind::keyword_for:
+				++depth;
+				break;
+			case token::kind::keyword_end:
+				--depth;
+				break;
+			case token::kind::keyword_fn:
+			case token::kind::end_of_stream:
+				return body; // never closed, the function reports the missing end
+			default:
+				break;
+			}
+		}
+
+		return body;
+	}
+
+	std::uint32_t parser::parse_statement()
+	{
+		switch (m_token.type) {
+		case token::kind::keyword_let:
+			return parse_variable_definition();
+		case token::kind::keyword_return:
+			return parse_return_statement();
+		case token::kind::keyword_if:
+			return parse_if_statement();
+		case token::kind::keyword_while:
+			return parse_while_statement();
+		case token::kind::keyword_for:
+			return parse_for_statement();
+		case token::kind::keyword_break:
+		case token::kind::keyword_continue: {
+			std::uint32_t statement = leaf(m_token.type == token::kind::keyword_break ? node::kind::break_statement : node::kind::continue_statement);
+
+			scan();
+			consume(token::kind::semicolon, parser_error::kind::expected_semicolon);
+			return statement;
+		}
+		default: {
+			std::uint32_t expression = parse_expression();
+
+			consume(token::kind::semicolon, parser_error::kind::expected_semicolon);
+			return expression;
+		}
+		}
+	}
+
+	std::uint32_t parser::parse_return_statement()
+	{
+		std::size_t mark = m_pending.size();
+		std::uint32_t keyword = m_token_index;
+
+		scan(); // skip return
+		m_pending.push_back(m_token.type == token::kind::semicolon ? ast::dummy : parse_expression());
+		consume(token::kind::semicolon, parser_error::kind::expected_semicolon);
+
+		return close(node::kind::return_stmt, keyword, mark);
+	}
+
+	std::uint32_t parser::parse_if_statement()
+	{
+		std::size_t mark = m_pending.size();
+		std::uint32_t keyword = m_token_index;
+
+		scan(); // skip if
+		m_pending.push_back(parse_expression());
+		consume(token::kind::keyword_then, parser_error::kind::expected_then);
+
+		if (m_panic)
+			return abandon(keyword, mark);
+
+		m_pending.push_back(parse_statement_list());
+
+		while (m_token.type == token::kind::keyword_elseif) {
+			std::size_t branch = m_pending.size();
+			std::uint32_t elseif = m_token_index;
+
+			scan(); // skip elseif
+			m_pending.push_back(parse_expression());
+			consume(token::kind::keyword_then, parser_error::kind::expected_then);
+
+			if (m_panic)
+				return abandon(keyword, mark);
+
+			m_pending.push_back(parse_statement_list());
+			m_pending.push_back(close(node::kind::elseif_statement, elseif, branch));
+		}
+
+		if (m_token.type == token::kind::keyword_else) {
+			std::size_t branch = m_pending.size();
+			std::uint32_t otherwise = m_token_index;
+
+			scan(); // skip else
+			m_pending.push_back(parse_statement_list());
+			m_pending.push_back(close(node::kind::else_statement, otherwise, branch));
+		}
+
+		consume(token::kind::keyword_end, parser_error::kind::expected_end);
+		return close(node::kind::if_statement, keyword, mark);
+	}
+
+	std::uint32_t parser::parse_while_statement()
+	{
+		std::size_t mark = m_pending.size();
+		std::uint32_t keyword = m_token_index;
+
+		scan(); // skip while
+		m_pending.push_back(parse_expression());
+		consume(token::kind::keyword_do, parser_error::kind::expected_do);
+
+		if (m_panic)
+			return abandon(keyword, mark);
+
+		m_pending.push_back(parse_statement_list());
+		consume(token::kind::keyword_end, parser_error::kind::expected_end);
+
+		return close(node::kind::while_statement, keyword, mark);
+	}
+
+	std::uint32_t parser::parse_for_statement()
+	{
+		std::size_t mark = m_pending.size();
+		std::uint32_t keyword = m_token_index;
+
+		scan(); // skip for
+		consume(token::kind::keyword_let, parser_error::kind::expected_let);
+		m_scopes.push_scope();
+
+		std::uint32_t declaration = parse_declaration();
+
+		m_pending.push_back(declaration);
+		consume(token::kind::assign, parser_error::kind::expected_assign);
+		m_pending.push_back(parse_expression());
+		consume(token::kind::delimiter, parser_error::kind::expected_delimiter);
+		m_pending.push_back(parse_expression()); // limit
+
+		if (m_token.type == token::kind::delimiter) {
+			scan();
+			m_pending.push_back(parse_expression()); // step
+		} else {
+			m_pending.push_back(ast::dummy);
+		}
+
+		declare(declaration);
+		consume(token::kind::keyword_do, parser_error::kind::expected_do);
+
+		if (m_panic) {
+			m_scopes.pop_scope();
+			return abandon(keyword, mark);
+		}
+
+		m_pending.push_back(parse_statement_list());
+		consume(token::kind::keyword_end, parser_error::kind::expected_end);
+		m_scopes.pop_scope();
+
+		return close(node::kind::for_statement, keyword, mark);
+	}
+
+	std::uint32_t parser::parse_expression(int precedence)
+	{
+		std::uint32_t left = parse_unary_expression();
+
+		for (binding op = binding_of(m_token.type); op.precedence >= precedence; op = binding_of(m_token.type)) {
+			std::size_t mark = m_pending.size();
+			std::uint32_t operation = m_token_index;
+
+			m_pending.push_back(left);
+			scan();
+			m_pending.push_back(parse_expression(op.right ? op.precedence : op.precedence + 1));
+			left = close(op.type, operation, mark);
+		}
+
+		return left;
+	}
+
+	std::uint32_t parser::parse_unary_expression()
+	{
+		if (m_token.type != token::kind::logical_not && m_token.type != token::kind::subtract)
+			return parse_primary_expression();
+
+		std::size_t mark = m_pending.size();
+		std::uint32_t operation = m_token_index;
+
+		scan();
+		m_pending.push_back(parse_unary_expression());
+
+		return close(node::kind::unary_expression, operation, mark);
+	}
+
+	std::uint32_t parser::parse_primary_expression()
+	{
+		switch (m_token.type) {
+		case token::kind::parenthesis_left: {
+			scan();
+			std::uint32_t expression = parse_expression(); // grouping only, no node of its own
+			consume(token::kind::parenthesis_right, parser_error::kind::expected_parenthesis_right);
+			return expression;
+		}
+		case token::kind::literal_true:
+		case token::kind::literal_false:
+		case token::kind::literal_int:
+		case token::kind::literal_real: {
+			std::uint32_t literal = leaf(node::kind::primary_expression);
+
+			scan();
+			return literal;
+		}
+		case token::kind::intrinsic_line:
+		case token::kind::intrinsic_column: {
+			std::uint32_t intrinsic = leaf(node::kind::intrinsic_expression);
+
+			scan();
+			return intrinsic;
+		}
+		case token::kind::identifier: {
+			std::uint32_t name = m_token_index;
+
+			scan();
+
+			std::uint32_t use = m_token.type == token::kind::parenthesis_left ? parse_call_expression(name) : m_tree.add(node::kind::primary_expression, name);
+
+			resolve(use, name);
+			return use;
+		}
+		case token::kind::error: {
+			error_token();
+
+			std::uint32_t error = leaf(node::kind::error);
+
+			scan();
+			return error;
+		}
+		default:
+			fail(parser_error::kind::expected_expression);
+			return leaf(node::kind::error);
+		}
+	}
+
+	std::uint32_t parser::parse_call_expression(std::uint32_t callee)
+	{
+		std::size_t mark = m_pending.size();
+
+		scan(); // skip (
+
+		if (m_token.type != token::kind::parenthesis_right) {
+			for (m_pending.push_back(parse_expression()); m_token.type == token::kind::delimiter; m_pending.push_back(parse_expression()))
+				scan(); // skip ,
+		}
+
+		consume(token::kind::parenthesis_right, parser_error::kind::expected_parenthesis_right);
+		return close(node::kind::call_expression, callee, mark);
+	}
+
+	std::uint32_t parser::parse_type(bool complete)
+	{
+		std::size_t mark = m_pending.size();
+		bool none = m_token.type == token::kind::type_none;
+
+		while (m_token.type == token::kind::modifier_mut || m_token.type == token::kind::modifier_ref) {
+			m_pending.push_back(leaf(node::kind::terminal));
+			scan();
+		}
+
+		std::uint32_t base = m_token_index;
+
+		switch (m_token.type) {
+		case token::kind::type_none:
+			if (!none) // no modifiers on none
+				fail(parser_error::kind::expected_type);
+			[[fallthrough]];
+		case token::kind::type_bool:
+		case token::kind::type_int:
+		case token::kind::type_real:
+			scan();
+			break;
+		case token::kind::intrinsic_dropmut:
+		case token::kind::intrinsic_dropref:
+			scan();
+			m_pending.push_back(parse_type(true));
+			break;
+		case token::kind::intrinsic_type:
+			scan();
+			m_pending.push_back(parse_unary_expression());
+			break;
+		default:
+			fail(parser_error::kind::expected_type);
+			m_pending.resize(mark);
+			return leaf(node::kind::error);
+		}
+
+		std::uint32_t type = close(node::kind::type, base, mark);
+
+		while (m_token.type == token::kind::parenthesis_left) { // what came before is the return type
+			std::uint32_t parenthesis = m_token_index;
+
+			m_pending.push_back(type);
+			scan(); // skip (
+
+			if (m_token.type != token::kind::parenthesis_right) {
+				for (m_pending.push_back(parse_type(true)); m_token.type == token::kind::delimiter; m_pending.push_back(parse_type(true)))
+					scan(); // skip ,
+			}
+
+			consume(token::kind::parenthesis_right, parser_error::kind::expected_parenthesis_right);
+			type = close(node::kind::function_type, parenthesis, mark);
+			none = false;
+		}
+
+		if (complete && none)
+			fail(parser_error::kind::expected_type);
+
+		return type;
+	}
+
+	std::uint32_t parser::parse_declaration()
+	{
+		std::size_t mark = m_pending.size();
+
+		if (m_token.type != token::kind::identifier) {
+			fail(parser_error::kind::expected_identifier);
+			return leaf(node::kind::error);
+		}
+
+		std::uint32_t name = m_token_index;
+
+		expect(token::kind::colon, parser_error::kind::expected_colon);
+		scan();
+		m_pending.push_back(parse_type(true));
 
-		scan(stream, current); // skip let
-		parse_declaration(stream, current, definition);
+		return close(node::kind::declaration, name, mark);
 	}
 }
@@ -0,0 +1,294 @@
+#include <vector>
+#include "parser.hpp"
+#include "parser_tables.hpp"
+
+namespace cntlang
+{
+	constexpr std::uint16_t close_symbol = 2 * grammar::rule_symbol; // plus the rule, when its frame ends
+
+	constexpr typename parser_error::kind missing_token(typename token::kind kind) noexcept
+	{
+		switch (kind) {
+		case token::kind::identifier: return parser_error::kind::expected_identifier;
+		case token::kind::colon: return parser_error::kind::expected_colon;
+		case token::kind::semicolon: return parser_error::kind::expected_semicolon;
+		case token::kind::delimiter: return parser_error::kind::expected_delimiter;
+		case token::kind::assign: return parser_error::kind::expected_assign;
+		case token::kind::parenthesis_left: return parser_error::kind::expected_parenthesis_left;
+		case token::kind::parenthesis_right: return parser_error::kind::expected_parenthesis_right;
+		case token::kind::keyword_let: return parser_error::kind::expected_let;
+		case token::kind::keyword_then: return parser_error::kind::expected_then;
+		case token::kind::keyword_do: return parser_error::kind::expected_do;
+		case token::kind::keyword_end: return parser_error::kind::expected_end;
+		case token::kind::end_of_stream: return parser_error::kind::global_expected;
+		default: return parser_error::kind::expected_expression;
+		}
+	}
+
+	constexpr typename parser_error::kind missing_rule(grammar::rule rule) noexcept
+	{
+		switch (grammar::owners[static_cast<std::size_t>(rule)]) {
+		case grammar::rule::program: return parser_error::kind::global_expected;
+		case grammar::rule::declaration: return parser_error::kind::expected_identifier;
+		case grammar::rule::declaration_list: return parser_error::kind::expected_parenthesis_left;
+		case grammar::rule::type:
+		case grammar::rule::type_base:
+		case grammar::rule::TYPE_INTRINSIC:
+		case grammar::rule::TYPE_PRIMITIVE:
+		case grammar::rule::TYPE_LIST: return parser_error::kind::expected_type;
+		default: return parser_error::kind::expected_expression;
+		}
+	}
+
+	const ast& parser::parse_generated()
+	{
+		std::vector<std::uint16_t> stack{ grammar::rule_symbol + static_cast<std::uint16_t>(grammar::rule::program) };
+		std::vector<frame> frames{ { static_cast<std::uint8_t>(grammar::rule::program), 0, 0, ast::dummy, 0 } }; // the parent of program
+
+		m_tree.reserve(m_tokens ? m_tokens->size() : 4096);
+		stack.reserve(256);
+		frames.reserve(64);
+		scan();
+
+		while (!stack.empty()) {
+			std::uint16_t top = stack.back();
+
+			stack.pop_back();
+
+			if (top < grammar::rule_symbol) {
+				auto expected = static_cast<typename token::kind>(top);
+
+				match_rule(frames.back(), expected);
+
+				if (m_token.type != expected)
+					raise(missing_token(expected), m_token.offset);
+
+				scan();
+			} else if (top < close_symbol) {
+				std::size_t rule = top - grammar::rule_symbol;
+				auto next = static_cast<std::size_t>(m_token.type);
+				std::uint8_t production = next < grammar::token_count ? grammar::table[rule][next] : grammar::defaults[rule];
+
+				if (production == grammar::no_production)
+					raise(missing_rule(static_cast<grammar::rule>(rule)), m_token.offset);
+
+				if (rule < grammar::frame_rules) {
+					stack.push_back(close_symbol + rule);
+					frames.push_back({ static_cast<std::uint8_t>(rule), m_token_index, m_token_index, ast::dummy, static_cast<std::uint32_t>(m_pending.size()) });
+					open_rule(frames.back());
+				}
+
+				const auto& body = grammar::productions[production];
+
+				for (std::uint16_t index = body.count; index > 0; --index)
+					stack.push_back(grammar::symbols[body.first + index - 1]);
+			} else {
+				close_rule(frames.back(), frames[frames.size() - 2]);
+				frames.pop_back();
+			}
+		}
+
+		m_tree.set_root(m_pending.back());
+		m_pending.pop_back();
+		keep_scanned();
+
+		return m_tree;
+	}
+
+	void parser::open_rule(frame& current)
+	{
+		switch (static_cast<grammar::rule>(current.rule)) {
+		case grammar::rule::program: // globals
+		case grammar::rule::statement_list:
+		case grammar::rule::for_statement:
+			m_scopes.push_scope();
+			break;
+		case grammar::rule::type_function:
+			current.mark = static_cast<std::uint32_t>(m_pending.size() - 1); // what came before is the return type
+			break;
+		default:
+			break;
+		}
+	}
+
+	void parser::match_rule(frame& current, typename token::kind expected)
+	{
+		std::size_t count = m_pending.size() - current.mark;
+
+		switch (static_cast<grammar::rule>(current.rule)) {
+		case grammar::rule::function_definition:
+			if (expected == token::kind::identifier && m_token.type == expected) { // children come later, the body may call it
+				current.node = leaf(node::kind::function_definition);
+				declare(current.node);
+				m_scopes.push_scope();
+			}
+			break;
+		case grammar::rule::variable_definition:
+			if (expected == token::kind::semicolon) {
+				if (count == 1)
+					m_pending.push_back(ast::dummy);
+
+				declare(m_pending[current.mark]); // not visible in its own initializer
+			}
+			break;
+		case grammar::rule::return_stmt:
+			if (expected == token::kind::semicolon && count == 0)
+				m_pending.push_back(ast::dummy);
+			break;
+		case grammar::rule::for_statement:
+			if (expected == token::kind::keyword_do) {
+				if (count == 3)
+					m_pending.push_back(ast::dummy); // step
+
+				declare(m_pending[current.mark]);
+			}
+			break;
+		case grammar::rule::assignment_expression:
+			current.token = m_token_index;
+			break;
+		case grammar::rule::logical_expression:
+			fold(current, node::kind::logical_expression);
+			current.token = m_token_index;
+			break;
+		case grammar::rule::relational_expression:
+			fold(current, node::kind::relational_expression);
+			current.token = m_token_index;
+			break;
+		case grammar::rule::additive_expression:
+			fold(current, node::kind::additive_expression);
+			current.token = m_token_index;
+			break;
+		case grammar::rule::multiplicative_expression:
+			fold(current, node::kind::multiplicative_expression);
+			current.token = m_token_index;
+			break;
+		case grammar::rule::type_base:
+			if (expected == token::kind::type_none && count > 0) // no modifiers on none
+				raise(parser_error::kind::expected_type, m_token.offset);
+
+			current.token = m_token_index;
+			break;
+		default:
+			break;
+		}
+	}
+
+	void parser::close_rule(const frame& current, const frame& parent)
+	{
+		std::size_t count = m_pending.size() - current.mark;
+
+		switch (static_cast<grammar::rule>(current.rule)) {
+		case grammar::rule::program:
+			resolve_globals();
+			m_pending.push_back(close(node::kind::program, node::no_token, current.mark));
+			break;
+		case grammar::rule::variable_definition:
+			m_pending.push_back(close(node::kind::variable_definition, current.start, current.mark));
+			break;
+		case grammar::rule::function_definition:
+			m_scopes.pop_scope();
+			close(current.node, current.mark);
+			m_pending.push_back(current.node);
+			break;
+		case grammar::rule::declaration:
+			m_pending.push_back(close(node::kind::declaration, current.start, current.mark));
+
+			if (parent.rule == static_cast<std::uint8_t>(grammar::rule::declaration_list))
+				declare(m_pending.back());
+			break;
+		case grammar::rule::declaration_list:
+			m_pending.push_back(close(node::kind::declaration_list, current.start, current.mark));
+			break;
+		case grammar::rule::statement_list:
+			m_scopes.pop_scope();
+			m_pending.push_back(close(node::kind::statement_list, current.start, current.mark));
+			break;
+		case grammar::rule::return_stmt:
+			m_pending.push_back(close(node::kind::return_stmt, current.start, current.mark));
+			break;
+		case grammar::rule::if_statement:
+			m_pending.push_back(close(node::kind::if_statement, current.start, current.mark));
+			break;
+		case grammar::rule::elseif_statement:
+			m_pending.push_back(close(node::kind::elseif_statement, current.start, current.mark));
+			break;
+		case grammar::rule::else_statement:
+			m_pending.push_back(close(node::kind::else_statement, current.start, current.mark));
+			break;
+		case grammar::rule::while_statement:
+			m_pending.push_back(close(node::kind::while_statement, current.start, current.mark));
+			break;
+		case grammar::rule::for_statement:
+			m_scopes.pop_scope();
+			m_pending.push_back(close(node::kind::for_statement, current.start, current.mark));
+			break;
+		case grammar::rule::break_stmt:
+			m_pending.push_back(m_tree.add(node::kind::break_statement, current.start));
+			break;
+		case grammar::rule::continue_stmt:
+			m_pending.push_back(m_tree.add(node::kind::continue_statement, current.start));
+			break;
+		case grammar::rule::assignment_expression:
+			if (count == 2)
+				m_pending.push_back(close(node::kind::assignment_expression, current.token, current.mark));
+			break;
+		case grammar::rule::logical_expression:
+			fold(current, node::kind::logical_expression);
+			break;
+		case grammar::rule::relational_expression:
+			fold(current, node::kind::relational_expression);
+			break;
+		case grammar::rule::additive_expression:
+			fold(current, node::kind::additive_expression);
+			break;
+		case grammar::rule::multiplicative_expression:
+			fold(current, node::kind::multiplicative_expression);
+			break;
+		case grammar::rule::unary_expression:
+			if (tokens().type(current.start) == token::kind::logical_not || tokens().type(current.start) == token::kind::subtract)
+				m_pending.push_back(close(node::kind::unary_expression, current.start, current.mark));
+			break;
+		case grammar::rule::intrinsic_expression:
+			m_pending.push_back(m_tree.add(node::kind::intrinsic_expression, current.start));
+			break;
+		case grammar::rule::primary_expression:
+			if (tokens().type(current.start) == token::kind::identifier) {
+				if (count == 0) // a name rather than a call
+					m_pending.push_back(m_tree.add(node::kind::primary_expression, current.start));
+
+				resolve(m_pending.back(), current.start);
+			} else if (tokens().type(current.start) != token::kind::parenthesis_left) { // grouping only, no node of its own
+				m_pending.push_back(m_tree.add(node::kind::primary_expression, current.start));
+			}
+			break;
+		case grammar::rule::call_expression:
+			m_pending.push_back(close(node::kind::call_expression, parent.start, current.mark)); // named by the callee
+			break;
+		case grammar::rule::type: {
+			std::uint32_t type = m_pending.back();
+			bool none = m_tree[type].type == node::kind::type && tokens().type(m_tree.token(type)) == token::kind::type_none;
+
+			if (none && parent.rule != static_cast<std::uint8_t>(grammar::rule::function_definition)) // only a return type may be none
+				raise(parser_error::kind::expected_type, m_token.offset);
+			break;
+		}
+		case grammar::rule::type_base:
+			m_pending.push_back(close(node::kind::type, current.token, current.mark));
+			break;
+		case grammar::rule::type_function:
+			m_pending.push_back(close(node::kind::function_type, current.start, current.mark));
+			break;
+		case grammar::rule::modifier:
+			m_pending.push_back(m_tree.add(node::kind::terminal, current.start));
+			break;
+		default:
+			break;
+		}
+	}
+
+	void parser::fold(const frame& current, typename node::kind type)
+	{
+		if (m_pending.size() - current.mark == 2) // the operator before and both its operands, left-associative
+			m_pending.push_back(close(type, current.token, current.mark));
+	}
+}
@@ -0,0 +1,202 @@
+#include "scan.hpp"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define CNTLANG_SCAN_X86 1
+#include <immintrin.h>
+#endif
+
+namespace cntlang
+{
+	struct scanner_set
+	{
+		scanner whitespace;
+		scanner line;
+		scanner identifier;
+	};
+
+	inline bool is_whitespace_byte(char chr) noexcept
+	{
+		return chr == ' ' || chr == '\t' || chr == '\r' || chr == '\n';
+	}
+
+	inline bool is_line_byte(char chr) noexcept
+	{
+		return chr != '\n' && chr != '\xFF';
+	}
+
+	inline bool is_identifier_byte(char chr) noexcept
+	{
+		return (chr >= 'A' && chr <= 'Z') || (chr >= 'a' && chr <= 'z') || (chr >= '0' && chr <= '9') || chr == '_';
+	}
+
+	const char* scan_whitespace_scalar(const char* first, const char* last) noexcept
+	{
+		while (first != last && is_whitespace_byte(*first))
+			++first;
+
+		return first;
+	}
+
+	const char* scan_line_scalar(const char* first, const char* last) noexcept
+	{
+		while (first != last && is_line_byte(*first))
+			++first;
+
+		return first;
+	}
+
+	const char* scan_identifier_scalar(const char* first, const char* last) noexcept
+	{
+		while (first != last && is_identifier_byte(*first))
+			++first;
+
+		return first;
+	}
+
+#ifdef CNTLANG_SCAN_X86
+	// The vector scanners build a mask of bytes that continue the run, 16 or 32 at a time,
+	// and stop at the first clear bit; the tail shorter than a vector is finished by the scalar loop.
+
+	__attribute__((target("sse2")))
+	inline __m128i whitespace_mask(__m128i bytes) noexcept
+	{
+		return _mm_or_si128(
+			_mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(bytes, _mm_set1_epi8('\t'))),
+			_mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('\r')), _mm_cmpeq_epi8(bytes, _mm_set1_epi8('\n'))));
+	}
+
+	__attribute__((target("sse2")))
+	inline __m128i line_end_mask(__m128i bytes) noexcept
+	{
+		return _mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('\n')), _mm_cmpeq_epi8(bytes, _mm_set1_epi8('\xFF')));
+	}
+
+	__attribute__((target("sse2")))
+	inline __m128i identifier_mask(__m128i bytes) noexcept
+	{
+		__m128i lower = _mm_or_si128(bytes, _mm_set1_epi8(0x20));
+		__m128i letter = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(lower, _mm_set1_epi8('z' + 1)));
+		__m128i digit = _mm_and_si128(_mm_cmpgt_epi8(bytes, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(bytes, _mm_set1_epi8('9' + 1)));
+
+		return _mm_or_si128(_mm_or_si128(letter, digit), _mm_cmpeq_epi8(bytes, _mm_set1_epi8('_')));
+	}
+
+	__attribute__((target("sse2")))
+	const char* scan_whitespace_sse2(const char* first, const char* last) noexcept
+	{
+		for (; last - first >= 16; first += 16) {
+			unsigned mask = ~_mm_movemask_epi8(whitespace_mask(_mm_loadu_si128(reinterpret_cast<const __m128i*>(first)))) & 0xFFFF;
+
+			if (mask)
+				return first + __builtin_ctz(mask);
+		}
+
+		return scan_whitespace_scalar(first, last);
+	}
+
+	__attribute__((target("sse2")))
+	const char* scan_line_sse2(const char* first, const char* last) noexcept
+	{
+		for (; last - first >= 16; first += 16) {
+			unsigned mask = _mm_movemask_epi8(line_end_mask(_mm_loadu_si128(reinterpret_cast<const __m128i*>(first))));
+
+			if (mask)
+				return first + __builtin_ctz(mask);
+		}
+
+		return scan_line_scalar(first, last);
+	}
+
+	__attribute__((target("sse2")))
+	const char* scan_identifier_sse2(const char* first, const char* last) noexcept
+	{
+		for (; last - first >= 16; first += 16) {
+			unsigned mask = ~_mm_movemask_epi8(identifier_mask(_mm_loadu_si128(reinterpret_cast<const __m128i*>(first)))) & 0xFFFF;
+
+			if (mask)
+				return first + __builtin_ctz(mask);
+		}
+
+		return scan_identifier_scalar(first, last);
+	}
+
+	__attribute__((target("avx2")))
+	const char* scan_whitespace_avx2(const char* first, const char* last) noexcept
+	{
+		for (; last - first >= 32; first += 32) {
+			__m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(first));
+			__m256i mask = _mm256_or_si256(
+				_mm256_or_si256(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\t'))),
+				_mm256_or_si256(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\r')), _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\n'))));
+
+			if (unsigned stop = ~static_cast<unsigned>(_mm256_movemask_epi8(mask)))
+				return first + __builtin_ctz(stop);
+		}
+
+		return scan_whitespace_sse2(first, last);
+	}
+
+	__attribute__((target("avx2")))
+	const char* scan_line_avx2(const char* first, const char* last) noexcept
+	{
+		for (; last - first >= 32; first += 32) {
+			__m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(first));
+			__m256i mask = _mm256_or_si256(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\n')), _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\xFF')));
+
+			if (unsigned stop = static_cast<unsigned>(_mm256_movemask_epi8(mask)))
+				return first + __builtin_ctz(stop);
+		}
+
+		return scan_line_sse2(first, last);
+	}
+
+	__attribute__((target("avx2")))
+	const char* scan_identifier_avx2(const char* first, const char* last) noexcept
+	{
+		for (; last - first >= 32; first += 32) {
+			__m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(first));
+			__m256i lower = _mm256_or_si256(bytes, _mm256_set1_epi8(0x20));
+			__m256i letter = _mm256_and_si256(_mm256_cmpgt_epi8(lower, _mm256_set1_epi8('a' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), lower));
+			__m256i digit = _mm256_and_si256(_mm256_cmpgt_epi8(bytes, _mm256_set1_epi8('0' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), bytes));
+			__m256i mask = _mm256_or_si256(_mm256_or_si256(letter, digit), _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('_')));
+
+			if (unsigned stop = ~static_cast<unsigned>(_mm256_movemask_epi8(mask)))
+				return first + __builtin_ctz(stop);
+		}
+
+		return scan_identifier_sse2(first, last);
+	}
+#endif
+
+	scanner_set select_scanners() noexcept
+	{
+#ifdef CNTLANG_SCAN_X86
+		__builtin_cpu_init();
+
+		if (__builtin_cpu_supports("avx2"))
+			return { scan_whitespace_avx2, scan_line_avx2, scan_identifier_avx2 };
+
+		if (__builtin_cpu_supports("sse2"))
+			return { scan_whitespace_sse2, scan_line_sse2, scan_identifier_sse2 };
+#endif
+
+		return { scan_whitespace_scalar, scan_line_scalar, scan_identifier_scalar };
+	}
+
+	const scanner_set selected_scanners = select_scanners();
+
+	const char* scan_whitespace(const char* first, const char* last) noexcept
+	{
+		return selected_scanners.whitespace(first, last);
+	}
+
+	const char* scan_line(const char* first, const char* last) noexcept
+	{
+		return selected_scanners.line(first, last);
+	}
+
+	const char* scan_identifier(const char* first, const char* last) noexcept
+	{
+		return selected_scanners.identifier(first, last);
+	}
+}
@@ -1,17 +1,28 @@
+#include <cstring>
 #include <stdexcept>
 #include "stream_info.hpp"
 
 using namespace cntlang;
 
 stream_info::stream_info(std::istream& stream, std::string source, std::size_t bufferSize)
-: m_stream(stream)
+: m_stream(&stream)
 , m_source(std::move(source))
 {
 	if (bufferSize < 4)
 		throw std::invalid_argument("buffer size must be at least 4 bytes large");
 
-	m_buffer.reserve(bufferSize);
-	m_stream.rdbuf()->pubsetbuf(m_buffer.data(), bufferSize);
+	m_buffer.resize(bufferSize);
+	m_cursor = m_end = m_origin = m_indexed = m_buffer.data();
+}
+
+stream_info::stream_info(std::string_view contents, std::string source)
+: m_source(std::move(source))
+, m_cursor(contents.data())
+, m_end(contents.data() + contents.size())
+, m_origin(contents.data())
+, m_indexed(contents.data())
+, m_bytes_read(contents.size())
+{
 }
 
 const std::string& stream_info::source() const noexcept
@@ -19,33 +30,62 @@ const std::string& stream_info::source() const noexcept
 	return m_source;
 }
 
-int stream_info::line() const noexcept
+std::size_t stream_info::offset() const noexcept
+{
+	return m_origin_offset + (m_cursor - m_origin);
+}
+
+int stream_info::line()
+{
+	return locate(offset()).line;
+}
+
+int stream_info::column()
+{
+	return locate(offset()).column;
+}
+
+position stream_info::locate()
+{
+	return locate(offset());
+}
+
+position stream_info::locate(std::size_t offset)
+{
+	index_lines(m_cursor);
+	return m_lines.locate(offset);
+}
+
+const line_index& stream_info::lines()
+{
+	index_lines(m_cursor);
+	return m_lines;
+}
+
+std::size_t stream_info::bytes_read() const noexcept
 {
-	return m_line;
+	return m_bytes_read;
 }
 
-int stream_info::column() const noexcept
+std::size_t stream_info::refills() const noexcept
 {
-	return m_column;
+	return m_refills;
 }
 
 char stream_info::peek()
 {
-	return m_stream.peek();
+	if (m_cursor == m_end && !refill())
+		return eof;
+
+	return *m_cursor;
 }
 
 char stream_info::get()
 {
-	int chr = m_stream.get();
-
-	if (chr == '\n') {
-		m_line += 1;
-		m_column = 1;
-	} else if (chr != eof) {
-		m_column += 1;
-	}
+	if (m_cursor == m_end && !refill())
+		return eof;
 
-	return chr;
+	return *m_cursor++;
 }
 
 char stream_info::next()
@@ -53,3 +93,75 @@ char stream_info::next()
 	get();
 	return peek();
 }
+
+void stream_info::skip(scanner scan)
+{
+	while (m_cursor != m_end || refill()) {
+		m_cursor = scan(m_cursor, m_end);
+
+		if (m_cursor != m_end)
+			break;
+	}
+}
+
+void stream_info::begin_lexeme() noexcept
+{
+	m_lexeme = m_cursor;
+}
+
+std::string_view stream_info::end_lexeme() noexcept
+{
+	std::string_view lexeme(m_lexeme, m_cursor - m_lexeme);
+
+	m_lexeme = nullptr;
+	return lexeme;
+}
+
+bool stream_info::refill() // m_cursor == m_end
+{
+	if (!m_stream)
+		return false;
+
+	index_lines(m_end);
+
+	// a lexeme in progress is moved to the front so it stays contiguous across chunks
+	std::size_t kept = m_lexeme ? m_end - m_lexeme : 0;
+
+	m_origin_offset += (m_end - m_origin) - kept;
+
+	if (kept == m_buffer.size()) {
+		std::size_t offset = m_lexeme - m_buffer.data();
+
+		m_buffer.resize(m_buffer.size() * 2);
+		m_lexeme = m_buffer.data() + offset;
+	}
+
+	char* data = m_buffer.data();
+
+	if (kept > 0)
+		std::memmove(data, m_lexeme, kept);
+
+	m_stream->read(data + kept, m_buffer.size() - kept);
+
+	std::size_t count = m_stream->gcount();
+
+	m_origin = data;
+	m_lexeme = m_lexeme ? data : nullptr;
+	m_cursor = m_indexed = data + kept;
+	m_end = m_cursor + count;
+	m_bytes_read += count;
+
+	if (count == 0) // the read that finds eof is not a refill
+		return false;
+
+	m_refills += 1;
+	return true;
+}
+
+void stream_info::index_lines(const char* last)
+{
+	if (m_indexed < last) {
+		m_lines.scan(m_indexed, last, m_origin_offset + (m_indexed - m_origin));
+		m_indexed = last;
+	}
+}
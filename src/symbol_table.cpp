@@ -0,0 +1,62 @@
+#include <algorithm>
+#include "symbol_table.hpp"
+
+using namespace cntlang;
+
+symbol_table::symbol_table(std::size_t expectedSymbols)
+{
+	m_heads.resize(expectedSymbols, not_found);
+	m_entries.reserve(expectedSymbols);
+	m_scopes.reserve(64);
+}
+
+void symbol_table::push_scope()
+{
+	m_scopes.push_back(static_cast<std::uint32_t>(m_entries.size()));
+}
+
+void symbol_table::pop_scope() noexcept
+{
+	std::uint32_t first = m_scopes.back();
+
+	for (std::size_t index = m_entries.size(); index-- > first;)
+		m_heads[m_entries[index].symbol] = m_entries[index].shadowed;
+
+	m_entries.resize(first);
+	m_scopes.pop_back();
+}
+
+bool symbol_table::declare(std::uint32_t symbol, std::uint32_t declaration)
+{
+	if (symbol >= m_heads.size())
+		m_heads.resize(std::max<std::size_t>(symbol + 1, m_heads.size() * 2), not_found);
+
+	std::uint32_t head = m_heads[symbol];
+	std::uint32_t scope = m_scopes.empty() ? 0 : m_scopes.back();
+
+	if (head != not_found && head >= scope)
+		return false;
+
+	m_entries.push_back({ symbol, declaration, head });
+	m_heads[symbol] = static_cast<std::uint32_t>(m_entries.size() - 1);
+	return true;
+}
+
+std::uint32_t symbol_table::lookup(std::uint32_t symbol) const noexcept
+{
+	if (symbol >= m_heads.size() || m_heads[symbol] == not_found)
+		return not_found;
+
+	return m_entries[m_heads[symbol]].declaration;
+}
+
+std::uint32_t symbol_table::depth() const noexcept
+{
+	return static_cast<std::uint32_t>(m_scopes.size());
+}
+
+void symbol_table::renumber(const std::vector<std::uint32_t>& declarations) noexcept
+{
+	for (entry& declared : m_entries)
+		declared.declaration = declarations[declared.declaration];
+}
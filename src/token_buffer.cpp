@@ -0,0 +1,345 @@
+#include <algorithm>
+#include <cstring>
+#include <exception>
+#include <stdexcept>
+#include <thread>
+#include "token_buffer.hpp"
+#include "work_stealing.hpp"
+
+namespace cntlang
+{
+	void token_buffer::reserve(std::size_t count)
+	{
+		m_types.reserve(count);
+		m_offsets.reserve(count);
+		m_lengths.reserve(count);
+		m_payloads.reserve(count);
+	}
+
+	void token_buffer::resize(std::size_t count)
+	{
+		m_types.resize(count);
+		m_offsets.resize(count);
+		m_lengths.resize(count);
+		m_payloads.resize(count);
+	}
+
+	void token_buffer::push(const token_view& tkn)
+	{
+		m_types.push_back(static_cast<std::uint8_t>(tkn.type));
+		m_offsets.push_back(tkn.offset);
+		m_lengths.push_back(tkn.length);
+		m_payloads.push_back(encode_payload(tkn));
+	}
+
+	void token_buffer::set(std::uint32_t index, const token_view& tkn) noexcept
+	{
+		m_types[index] = static_cast<std::uint8_t>(tkn.type);
+		m_offsets[index] = tkn.offset;
+		m_lengths[index] = tkn.length;
+		m_payloads[index] = encode_payload(tkn);
+	}
+
+	std::uint32_t token_buffer::size() const noexcept
+	{
+		return static_cast<std::uint32_t>(m_types.size());
+	}
+
+	token_view token_buffer::operator[](std::uint32_t index) const noexcept
+	{
+		token_view tkn{ type(index), m_offsets[index], m_lengths[index], 0, {} };
+
+		if (tkn.type == token::kind::literal_int || tkn.type == token::kind::literal_real)
+			std::memcpy(&tkn.value, &m_payloads[index], sizeof(tkn.value));
+		else
+			tkn.symbol = static_cast<std::uint32_t>(m_payloads[index]);
+
+		return tkn;
+	}
+
+	void token_buffer::splice(std::uint32_t first, std::uint32_t removed, const token_buffer& inserted, std::int64_t shift)
+	{
+		auto replace = [first, removed](auto& target, const auto& source) {
+			auto position = target.erase(target.begin() + first, target.begin() + first + removed);
+			target.insert(position, source.begin(), source.end());
+		};
+
+		replace(m_types, inserted.m_types);
+		replace(m_offsets, inserted.m_offsets);
+		replace(m_lengths, inserted.m_lengths);
+		replace(m_payloads, inserted.m_payloads);
+
+		for (std::size_t index = first + inserted.size(); index < m_offsets.size(); ++index)
+			m_offsets[index] = static_cast<std::uint32_t>(m_offsets[index] + shift);
+	}
+
+	std::uint32_t token_buffer::find(std::uint32_t offset) const noexcept
+	{
+		return static_cast<std::uint32_t>(std::lower_bound(m_offsets.begin(), m_offsets.end(), offset) - m_offsets.begin());
+	}
+
+	typename token::kind token_buffer::type(std::uint32_t index) const noexcept
+	{
+		return static_cast<typename token::kind>(m_types[index]);
+	}
+
+	std::uint32_t token_buffer::offset(std::uint32_t index) const noexcept
+	{
+		return m_offsets[index];
+	}
+
+	std::uint32_t token_buffer::length(std::uint32_t index) const noexcept
+	{
+		return m_lengths[index];
+	}
+
+	std::uint64_t token_buffer::payload(std::uint32_t index) const noexcept
+	{
+		return m_payloads[index];
+	}
+
+	line_index& token_buffer::lines() noexcept
+	{
+		return m_lines;
+	}
+
+	const line_index& token_buffer::lines() const noexcept
+	{
+		return m_lines;
+	}
+
+	position token_buffer::locate(std::uint32_t index) const noexcept
+	{
+		return m_lines.locate(m_offsets[index]);
+	}
+
+	std::uint64_t token_buffer::encode_payload(const token_view& tkn) noexcept
+	{
+		std::uint64_t payload = tkn.symbol;
+
+		if (tkn.type == token::kind::literal_int || tkn.type == token::kind::literal_real)
+			std::memcpy(&payload, &tkn.value, sizeof(payload));
+
+		return payload;
+	}
+
+	template<typename Lexer>
+	token_buffer tokenize_with(stream_info& stream, Lexer lex)
+	{
+		token_buffer tokens;
+		token_view tkn;
+
+		tokens.reserve(std::max<std::size_t>(4096, stream.bytes_read() / 6)); // bytes_read is the whole source when memory-backed
+
+		do {
+			tkn = lex(stream);
+			tokens.push(tkn);
+		} while (tkn.type != token::kind::end_of_stream);
+
+		tokens.lines() = stream.lines();
+		return tokens;
+	}
+
+	token_buffer tokenize(stream_info& stream, interner& symbols)
+	{
+		return tokenize_with(stream, [&symbols](stream_info& stream) { return next_token(stream, symbols); });
+	}
+
+	token_buffer tokenize(stream_info& stream, interner& symbols, std::vector<lexical_diagnostic>& diagnostics)
+	{
+		return tokenize_with(stream, [&symbols, &diagnostics](stream_info& stream) { return next_token(stream, symbols, diagnostics); });
+	}
+
+	struct lexed_chunk
+	{
+		std::string_view source;
+		std::size_t base; // offset of source in the whole file
+		token_buffer tokens;
+		interner symbols;
+		std::vector<std::uint32_t> symbol_map; // local symbol -> shared symbol
+		std::uint32_t first_token = 0;
+		std::size_t first_line = 0; // newlines before this chunk
+		bool failed = false;
+		typename lexical_error::kind error;
+		position error_position;
+		std::exception_ptr exception;
+	};
+
+	void lex_chunk(lexed_chunk& chunk)
+	{
+		stream_info stream(chunk.source);
+
+		try {
+			chunk.tokens = tokenize(stream, chunk.symbols);
+		} catch (const lexical_error& error) {
+			chunk.failed = true;
+			chunk.error = error.error();
+			chunk.error_position = { error.line(), error.column() };
+		} catch (...) {
+			chunk.failed = true;
+			chunk.exception = std::current_exception();
+		}
+	}
+
+	void splice_chunk(lexed_chunk& chunk, token_buffer& tokens, std::uint32_t count)
+	{
+		for (std::uint32_t index = 0; index < count; ++index) {
+			token_view tkn = chunk.tokens[index];
+
+			tkn.offset += static_cast<std::uint32_t>(chunk.base);
+
+			if (tkn.type == token::kind::identifier)
+				tkn.symbol = chunk.symbol_map[tkn.symbol];
+
+			tokens.set(chunk.first_token + index, tkn);
+		}
+	}
+
+	template<typename Function>
+	void run_chunks(std::vector<lexed_chunk>& chunks, std::size_t count, Function function)
+	{
+		std::vector<std::thread> workers;
+
+		workers.reserve(count - 1);
+
+		for (std::size_t index = 1; index < count; ++index)
+			workers.emplace_back(function, std::ref(chunks[index]), index);
+
+		function(chunks[0], 0);
+
+		for (auto& worker : workers)
+			worker.join();
+	}
+
+	token_buffer tokenize_parallel(std::string_view source, interner& symbols, unsigned threads)
+	{
+		constexpr std::size_t min_chunk_size = 1 << 20;
+
+		if (source.size() > UINT32_MAX)
+			throw std::length_error("token views address at most 4 GiB of source");
+
+		threads = static_cast<unsigned>(std::min<std::size_t>(usable_threads(threads), source.size() / min_chunk_size));
+
+		if (threads <= 1) {
+			stream_info stream(source);
+			return tokenize(stream, symbols);
+		}
+
+		// no token spans a newline, so every chunk starts at the beginning of a line
+		std::vector<lexed_chunk> chunks(threads);
+		std::size_t begin = 0;
+
+		for (unsigned index = 0; index < threads; ++index) {
+			std::size_t end = source.size();
+
+			if (index + 1 < threads) {
+				end = std::max(begin, source.size() * (index + 1) / threads);
+
+				const void* newline = std::memchr(source.data() + end, '\n', source.size() - end);
+				end = newline ? static_cast<const char*>(newline) - source.data() + 1 : source.size();
+			}
+
+			chunks[index].source = source.substr(begin, end - begin);
+			chunks[index].base = begin;
+			begin = end;
+		}
+
+		run_chunks(chunks, chunks.size(), [](lexed_chunk& chunk, std::size_t) { lex_chunk(chunk); });
+
+		// the serial lexer stops at the first error or eof byte, so does the joined stream
+		std::size_t last = 0;
+		std::uint32_t count = 0;
+		std::size_t lines = 0;
+
+		for (;; ++last) {
+			lexed_chunk& chunk = chunks[last];
+
+			chunk.first_token = count;
+			chunk.first_line = lines;
+
+			if (chunk.exception)
+				std::rethrow_exception(chunk.exception);
+			else if (chunk.failed)
+				throw lexical_error(chunk.error, chunk.error_position.line + static_cast<int>(lines), chunk.error_position.column);
+
+			std::uint32_t size = chunk.tokens.size();
+			bool reachedEnd = chunk.tokens.offset(size - 1) < chunk.source.size() || last + 1 == chunks.size();
+
+			count += reachedEnd ? size : size - 1; // inner chunks drop their end_of_stream
+			lines += chunk.tokens.lines().size() - 1;
+
+			chunk.symbol_map.resize(chunk.symbols.size());
+
+			for (std::uint32_t symbol = 0; symbol < chunk.symbols.size(); ++symbol)
+				chunk.symbol_map[symbol] = symbols.intern(chunk.symbols.name(symbol));
+
+			if (reachedEnd)
+				break;
+		}
+
+		token_buffer tokens;
+
+		tokens.resize(count);
+
+		run_chunks(chunks, last + 1, [&tokens, last](lexed_chunk& chunk, std::size_t index) {
+			splice_chunk(chunk, tokens, index == last ? chunk.tokens.size() : chunk.tokens.size() - 1);
+		});
+
+		for (std::size_t index = 0; index <= last; ++index)
+			tokens.lines().append(chunks[index].tokens.lines(), chunks[index].base);
+
+		return tokens;
+	}
+
+	token_change relex(token_buffer& tokens, std::string_view source, const text_edit& edit, interner& symbols, std::vector<lexical_diagnostic>& diagnostics)
+	{
+		if (source.size() > UINT32_MAX)
+			throw std::length_error("token views address at most 4 GiB of source");
+
+		// tokens never span a newline, so lexing can restart at the start of the edited line
+		std::size_t restart = tokens.lines().line_start(tokens.lines().locate(edit.offset).line);
+		std::uint32_t end = tokens.size() - 1;
+
+		if (restart > tokens.offset(end)) { // the stream already ended on an eof byte before the edit
+			tokens.lines().edit(edit.offset, edit.removed, source.substr(edit.offset, edit.inserted));
+			return { end, 0, 0 };
+		}
+
+		std::int64_t shift = static_cast<std::int64_t>(edit.inserted) - static_cast<std::int64_t>(edit.removed);
+		std::uint32_t first = tokens.find(static_cast<std::uint32_t>(restart));
+		std::uint32_t old = first;
+		stream_info stream(source.substr(restart));
+		token_buffer inserted;
+		std::size_t reported = diagnostics.size();
+
+		for (;;) {
+			token_view tkn = next_token(stream, symbols, diagnostics); // an edit in progress may not lex, the buffer follows it anyway
+
+			tkn.offset += static_cast<std::uint32_t>(restart);
+
+			// once a token starts where an old token past the edit started, the rest of the stream is unchanged
+			if (tkn.offset >= edit.offset + edit.inserted) {
+				while (old < tokens.size() && tokens.offset(old) + shift < tkn.offset)
+					++old;
+
+				if (old < tokens.size() && tokens.offset(old) + shift == tkn.offset && tokens.offset(old) >= edit.offset + edit.removed)
+					break;
+			}
+
+			inserted.push(tkn);
+
+			if (tkn.type == token::kind::end_of_stream) {
+				old = tokens.size();
+				break;
+			}
+		}
+
+		for (; reported < diagnostics.size(); ++reported)
+			diagnostics[reported].offset += static_cast<std::uint32_t>(restart);
+
+		tokens.splice(first, old - first, inserted, shift);
+		tokens.lines().edit(edit.offset, edit.removed, source.substr(edit.offset, edit.inserted));
+
+		return { first, old - first, inserted.size() };
+	}
+}
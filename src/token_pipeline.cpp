@@ -0,0 +1,130 @@
+#include "token_pipeline.hpp"
+
+using namespace cntlang;
+
+token_pipeline::token_pipeline(stream_info& stream, interner& symbols)
+: m_stream(stream)
+, m_symbols(symbols)
+{
+	m_diagnostics.reserve(1);
+	m_producer = std::thread(&token_pipeline::produce, this);
+}
+
+token_pipeline::~token_pipeline()
+{
+	stop();
+}
+
+token_view token_pipeline::next()
+{
+	if (m_batch_index == m_batch_size)
+		fill();
+
+	if (m_exhausted)
+		return m_end;
+
+	token_view tkn = m_batch[m_batch_index++];
+
+	if (tkn.type == token::kind::end_of_stream) {
+		m_end = tkn;
+		m_exhausted = true;
+	} else if (tkn.type == token::kind::error) {
+		stop();
+		throw lexical_error(static_cast<lexical_error::kind>(tkn.symbol), m_error_position.line, m_error_position.column);
+	}
+
+	return tkn;
+}
+
+position token_pipeline::locate(std::uint32_t offset)
+{
+	stop();
+	return m_stream.locate(offset);
+}
+
+const line_index& token_pipeline::lines()
+{
+	stop();
+	return m_stream.lines();
+}
+
+void token_pipeline::stop() noexcept
+{
+	m_stop.store(true, std::memory_order_relaxed);
+
+	if (m_producer.joinable())
+		m_producer.join();
+}
+
+void token_pipeline::produce() noexcept
+{
+	std::array<token_view, batch_size> batch;
+	std::size_t count = 0;
+
+	try {
+		for (;;) {
+			token_view tkn = next_token(m_stream, m_symbols, m_diagnostics);
+			bool last = tkn.type == token::kind::end_of_stream || tkn.type == token::kind::error;
+
+			if (tkn.type == token::kind::error) // resolved here, the consumer must not touch the stream
+				m_error_position = m_stream.locate(m_diagnostics.back().offset);
+
+			batch[count++] = tkn;
+
+			if (last || count == batch.size()) {
+				if (!publish(batch.data(), count))
+					break;
+
+				count = 0;
+			}
+
+			if (last)
+				break;
+		}
+	} catch (...) {
+		m_exception = std::current_exception();
+	}
+
+	m_done.store(true, std::memory_order_release);
+}
+
+bool token_pipeline::publish(const token_view* tokens, std::size_t count) noexcept
+{
+	while (count > 0) {
+		std::size_t pushed = m_ring.push(tokens, count);
+
+		tokens += pushed;
+		count -= pushed;
+
+		if (pushed == 0) {
+			if (m_stop.load(std::memory_order_relaxed))
+				return false;
+
+			std::this_thread::yield();
+		}
+	}
+
+	return true;
+}
+
+void token_pipeline::fill()
+{
+	m_batch_index = 0;
+
+	for (;;) {
+		bool done = m_done.load(std::memory_order_acquire);
+
+		if ((m_batch_size = m_ring.pop(m_batch.data(), m_batch.size())) > 0)
+			return;
+
+		if (done) {
+			if (m_exception)
+				std::rethrow_exception(m_exception);
+
+			m_exhausted = true; // only reachable after stop()
+			return;
+		}
+
+		std::this_thread::yield();
+	}
+}
@@ -1,5 +1,10 @@
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstdint>
 #include <string>
-#include <unordered_map>
+#include <string_view>
+#include "scan.hpp"
 #include "tokenizer.hpp"
 
 namespace cntlang
@@ -11,6 +16,22 @@ namespace cntlang
 	{
 	}
 
+	const char* lexical_error::describe(kind error) noexcept
+	{
+		switch (error) {
+		case kind::expected_exponent: return "expected exponent digits";
+		case kind::unknown_intrinsic: return "unknown intrinsic";
+		case kind::unexpected_symbol: return "unexpected symbol";
+		case kind::literal_overflow: return "literal out of range";
+		}
+
+		return "lexical error";
+	}
+
+	const char* lexical_error::what() const noexcept
+	{
+		return describe(m_error);
+	}
 
 	lexical_error::kind lexical_error::error() const noexcept
 	{
@@ -30,240 +51,483 @@ namespace cntlang
 
 namespace cntlang
 {
-	token handle_comment(stream_info& stream);
-	token handle_numeric(stream_info& stream);
-	token handle_keyword(stream_info& stream);
-	token handle_operator(stream_info& stream);
+	enum class char_class : std::uint8_t
+	{
+		other, letter, exponent, digit, dot, bang,
+		add, subtract, multiply, divide, remainder, equal, less, greater,
+		delimiter, colon, semicolon, parenthesis_left, parenthesis_right, ampersand,
+		count
+	};
+
+	enum class lex_state : std::uint8_t
+	{
+		reject, start,
+		identifier, intrinsic,
+		integer, fraction_dot, fraction, exponent, exponent_sign, exponent_digits,
+		delimiter, colon, semicolon, parenthesis_left, parenthesis_right, ampersand,
+		add, subtract, multiply, divide, remainder, assign, less, greater, bang,
+		assign_add, assign_subtract, assign_multiply, assign_divide, assign_remainder,
+		equal, not_equal, less_or_equal, greater_or_equal,
+		count
+	};
+
+	constexpr std::size_t class_count = static_cast<std::size_t>(char_class::count);
+	constexpr std::size_t state_count = static_cast<std::size_t>(lex_state::count);
+
+	using class_table = std::array<char_class, 256>;
+	using transition_table = std::array<std::array<lex_state, class_count>, state_count>;
+
+	struct accept_info
+	{
+		bool accepts;
+		typename token::kind type; // identifier for identifier and intrinsic states
+		typename lexical_error::kind error; // reported when the scan stops in a non-accepting state
+	};
+
+	constexpr class_table make_class_table()
+	{
+		class_table table{};
+
+		for (int chr = 'A'; chr <= 'Z'; ++chr)
+			table[chr] = table[chr + ('a' - 'A')] = char_class::letter;
+
+		for (int chr = '0'; chr <= '9'; ++chr)
+			table[chr] = char_class::digit;
+
+		table['_'] = char_class::letter;
+		table['e'] = table['E'] = char_class::exponent;
+		table['.'] = char_class::dot;
+		table['!'] = char_class::bang;
+		table['+'] = char_class::add;
+		table['-'] = char_class::subtract;
+		table['*'] = char_class::multiply;
+		table['/'] = char_class::divide;
+		table['%'] = char_class::remainder;
+		table['='] = char_class::equal;
+		table['<'] = char_class::less;
+		table['>'] = char_class::greater;
+		table[','] = char_class::delimiter;
+		table[':'] = char_class::colon;
+		table[';'] = char_class::semicolon;
+		table['('] = char_class::parenthesis_left;
+		table[')'] = char_class::parenthesis_right;
+		table['&'] = char_class::ampersand;
+
+		return table;
+	}
+
+	constexpr transition_table make_transition_table()
+	{
+		transition_table table{};
+		auto on = [&table](lex_state from, char_class by, lex_state to) constexpr {
+			table[static_cast<std::size_t>(from)][static_cast<std::size_t>(by)] = to;
+		};
+
+		on(lex_state::start, char_class::letter, lex_state::identifier);
+		on(lex_state::start, char_class::exponent, lex_state::identifier);
+		on(lex_state::identifier, char_class::letter, lex_state::identifier);
+		on(lex_state::identifier, char_class::exponent, lex_state::identifier);
+		on(lex_state::identifier, char_class::digit, lex_state::identifier);
+		on(lex_state::identifier, char_class::bang, lex_state::intrinsic);
+
+		on(lex_state::start, char_class::digit, lex_state::integer);
+		on(lex_state::integer, char_class::digit, lex_state::integer);
+		on(lex_state::integer, char_class::dot, lex_state::fraction_dot);
+		on(lex_state::integer, char_class::exponent, lex_state::exponent);
+		on(lex_state::fraction_dot, char_class::digit, lex_state::fraction);
+		on(lex_state::fraction_dot, char_class::exponent, lex_state::exponent);
+		on(lex_state::fraction, char_class::digit, lex_state::fraction);
+		on(lex_state::fraction, char_class::exponent, lex_state::exponent);
+		on(lex_state::exponent, char_class::add, lex_state::exponent_sign);
+		on(lex_state::exponent, char_class::subtract, lex_state::exponent_sign);
+		on(lex_state::exponent, char_class::digit, lex_state::exponent_digits);
+		on(lex_state::exponent_sign, char_class::digit, lex_state::exponent_digits);
+		on(lex_state::exponent_digits, char_class::digit, lex_state::exponent_digits);
+
+		on(lex_state::start, char_class::delimiter, lex_state::delimiter);
+		on(lex_state::start, char_class::colon, lex_state::colon);
+		on(lex_state::start, char_class::semicolon, lex_state::semicolon);
+		on(lex_state::start, char_class::parenthesis_left, lex_state::parenthesis_left);
+		on(lex_state::start, char_class::parenthesis_right, lex_state::parenthesis_right);
+		on(lex_state::start, char_class::ampersand, lex_state::ampersand);
+
+		on(lex_state::start, char_class::add, lex_state::add);
+		on(lex_state::start, char_class::subtract, lex_state::subtract);
+		on(lex_state::start, char_class::multiply, lex_state::multiply);
+		on(lex_state::start, char_class::divide, lex_state::divide);
+		on(lex_state::start, char_class::remainder, lex_state::remainder);
+		on(lex_state::start, char_class::equal, lex_state::assign);
+		on(lex_state::start, char_class::less, lex_state::less);
+		on(lex_state::start, char_class::greater, lex_state::greater);
+		on(lex_state::start, char_class::bang, lex_state::bang);
+
+		on(lex_state::add, char_class::equal, lex_state::assign_add);
+		on(lex_state::subtract, char_class::equal, lex_state::assign_subtract);
+		on(lex_state::multiply, char_class::equal, lex_state::assign_multiply);
+		on(lex_state::divide, char_class::equal, lex_state::assign_divide);
+		on(lex_state::remainder, char_class::equal, lex_state::assign_remainder);
+		on(lex_state::assign, char_class::equal, lex_state::equal);
+		on(lex_state::less, char_class::equal, lex_state::less_or_equal);
+		on(lex_state::greater, char_class::equal, lex_state::greater_or_equal);
+		on(lex_state::bang, char_class::equal, lex_state::not_equal);
+
+		return table;
+	}
+
+	constexpr std::array<accept_info, state_count> make_accept_table()
+	{
+		std::array<accept_info, state_count> table{};
+		auto accept = [&table](lex_state state, typename token::kind type) constexpr {
+			table[static_cast<std::size_t>(state)] = { true, type, lexical_error::kind::unexpected_symbol };
+		};
+
+		for (auto& info : table)
+			info = { false, token::kind::end_of_stream, lexical_error::kind::unexpected_symbol };
+
+		table[static_cast<std::size_t>(lex_state::exponent)].error = lexical_error::kind::expected_exponent;
+		table[static_cast<std::size_t>(lex_state::exponent_sign)].error = lexical_error::kind::expected_exponent;
+
+		accept(lex_state::identifier, token::kind::identifier);
+		accept(lex_state::intrinsic, token::kind::identifier);
+		accept(lex_state::integer, token::kind::literal_int);
+		accept(lex_state::fraction_dot, token::kind::literal_real);
+		accept(lex_state::fraction, token::kind::literal_real);
+		accept(lex_state::exponent_digits, token::kind::literal_real);
+		accept(lex_state::delimiter, token::kind::delimiter);
+		accept(lex_state::colon, token::kind::colon);
+		accept(lex_state::semicolon, token::kind::semicolon);
+		accept(lex_state::parenthesis_left, token::kind::parenthesis_left);
+		accept(lex_state::parenthesis_right, token::kind::parenthesis_right);
+		accept(lex_state::ampersand, token::kind::modifier_ref);
+		accept(lex_state::add, token::kind::add);
+		accept(lex_state::subtract, token::kind::subtract);
+		accept(lex_state::multiply, token::kind::multiply);
+		accept(lex_state::divide, token::kind::divide);
+		accept(lex_state::remainder, token::kind::remainder);
+		accept(lex_state::assign, token::kind::assign);
+		accept(lex_state::less, token::kind::less);
+		accept(lex_state::greater, token::kind::greater);
+		accept(lex_state::assign_add, token::kind::assign_add);
+		accept(lex_state::assign_subtract, token::kind::assign_subtract);
+		accept(lex_state::assign_multiply, token::kind::assign_multiply);
+		accept(lex_state::assign_divide, token::kind::assign_divide);
+		accept(lex_state::assign_remainder, token::kind::assign_remainder);
+		accept(lex_state::equal, token::kind::equal);
+		accept(lex_state::not_equal, token::kind::not_equal);
+		accept(lex_state::less_or_equal, token::kind::less_or_equal);
+		accept(lex_state::greater_or_equal, token::kind::greater_or_equal);
+
+		return table;
+	}
+
+	constexpr typename token::kind keyword_kind(std::string_view word) noexcept
+	{
+		switch (word.size()) {
+		case 2:
+			switch (word[0]) {
+			case 'f': if (word == "fn") return token::kind::keyword_fn; break;
+			case 'i': if (word == "if") return token::kind::keyword_if; break;
+			case 'd': if (word == "do") return token::kind::keyword_do; break;
+			case 'o': if (word == "or") return token::kind::logical_or; break;
+			}
+			break;
+		case 3:
+			switch (word[0]) {
+			case 'i': if (word == "int") return token::kind::type_int; break;
+			case 'm': if (word == "mut") return token::kind::modifier_mut; break;
+			case 'l': if (word == "let") return token::kind::keyword_let; break;
+			case 'e': if (word == "end") return token::kind::keyword_end; break;
+			case 'f': if (word == "for") return token::kind::keyword_for; break;
+			case 'n': if (word == "not") return token::kind::logical_not; break;
+			case 'a': if (word == "and") return token::kind::logical_and; break;
+			}
+			break;
+		case 4:
+			switch (word[0]) {
+			case 't':
+				if (word == "true") return token::kind::literal_true;
+				if (word == "then") return token::kind::keyword_then;
+				break;
+			case 'n': if (word == "none") return token::kind::type_none; break;
+			case 'b': if (word == "bool") return token::kind::type_bool; break;
+			case 'r': if (word == "real") return token::kind::type_real; break;
+			case 'e': if (word == "else") return token::kind::keyword_else; break;
+			}
+			break;
+		case 5:
+			switch (word[0]) {
+			case 'f': if (word == "false") return token::kind::literal_false; break;
+			case 'w': if (word == "while") return token::kind::keyword_while; break;
+			case 'b': if (word == "break") return token::kind::keyword_break; break;
+			case 't': if (word == "type!") return token::kind::intrinsic_type; break;
+			case 'l': if (word == "line!") return token::kind::intrinsic_line; break;
+			}
+			break;
+		case 6:
+			switch (word[0]) {
+			case 'r': if (word == "return") return token::kind::keyword_return; break;
+			case 'e': if (word == "elseif") return token::kind::keyword_elseif; break;
+			}
+			break;
+		case 7:
+			if (word == "column!") return token::kind::intrinsic_column;
+			break;
+		case 8:
+			switch (word[0]) {
+			case 'c': if (word == "continue") return token::kind::keyword_continue; break;
+			case 'd':
+				if (word == "dropmut!") return token::kind::intrinsic_dropmut;
+				if (word == "dropref!") return token::kind::intrinsic_dropref;
+				break;
+			}
+			break;
+		}
+
+		return token::kind::identifier;
+	}
+
+	static_assert(keyword_kind("elseif") == token::kind::keyword_elseif);
+	static_assert(keyword_kind("dropref!") == token::kind::intrinsic_dropref);
+	static_assert(keyword_kind("fnord") == token::kind::identifier);
+
+	constexpr class_table char_classes = make_class_table();
+	constexpr transition_table transitions = make_transition_table();
+	constexpr std::array<accept_info, state_count> accepts = make_accept_table();
+}
+
+namespace cntlang
+{
+	struct raw_token
+	{
+		typename token::kind type;
+		std::size_t offset;
+		std::string_view text; // valid until the next read
+		literal_value value;
+		typename lexical_error::kind error; // of error tokens
+		std::size_t error_offset;
+	};
+
+	raw_token scan_token(stream_info& stream);
+	raw_token handle_comment(stream_info& stream);
+	raw_token handle_lexeme(stream_info& stream);
+	void classify_identifier(raw_token& raw) noexcept;
+	void decode_literal(raw_token& raw) noexcept;
+	token_view view_of(const raw_token& raw, interner& symbols);
+	int decimal_magnitude(std::string_view content) noexcept;
+	[[noreturn]] void raise(stream_info& stream, typename lexical_error::kind error, std::size_t offset);
 
 	char skip_whitespace(stream_info& stream);
-	std::string read_integer(stream_info& stream);
 
 	bool is_epsilon(char chr) noexcept;
-	bool is_whitespace(char chr) noexcept;
 	bool is_character(char chr) noexcept;
 	bool is_newline(char chr) noexcept;
-	bool is_digit(char chr) noexcept;
-	bool is_identifier_begin(char chr) noexcept;
-	bool is_identifier_part(char chr) noexcept;
 
 	token next_token(stream_info& stream)
+	{
+		raw_token raw = scan_token(stream);
+
+		if (raw.type == token::kind::error)
+			raise(stream, raw.error, raw.error_offset);
+
+		auto [line, column] = stream.locate(raw.offset);
+
+		if (raw.type == token::kind::end_of_stream)
+			return { "<end-of-stream>", raw.type, line, column, raw.value };
+
+		return { std::string(raw.text), raw.type, line, column, raw.value };
+	}
+
+	token_view next_token(stream_info& stream, interner& symbols)
+	{
+		raw_token raw = scan_token(stream);
+
+		if (raw.type == token::kind::error)
+			raise(stream, raw.error, raw.error_offset);
+
+		return view_of(raw, symbols);
+	}
+
+	token_view next_token(stream_info& stream, interner& symbols, std::vector<lexical_diagnostic>& diagnostics)
+	{
+		raw_token raw = scan_token(stream);
+		token_view tkn = view_of(raw, symbols);
+
+		if (raw.type == token::kind::error)
+			diagnostics.push_back({ raw.error, static_cast<std::uint32_t>(raw.error_offset) });
+
+		return tkn;
+	}
+
+	token_view view_of(const raw_token& raw, interner& symbols)
+	{
+		if (raw.offset + raw.text.size() > UINT32_MAX)
+			throw std::length_error("token views address at most 4 GiB of source");
+
+		std::uint32_t symbol = 0;
+
+		if (raw.type == token::kind::identifier)
+			symbol = symbols.intern(raw.text);
+		else if (raw.type == token::kind::error)
+			symbol = static_cast<std::uint32_t>(raw.error);
+
+		return { raw.type, static_cast<std::uint32_t>(raw.offset), static_cast<std::uint32_t>(raw.text.size()), symbol, raw.value };
+	}
+
+	raw_token scan_token(stream_info& stream)
 	{
 		char chr = skip_whitespace(stream);
 
 		if (is_epsilon(chr))
-			return token{"<end-of-stream>", token::kind::end_of_stream, stream.line(), stream.column()};
+			return { token::kind::end_of_stream, stream.offset(), std::string_view(), {}, {}, 0 };
 		else if (chr == '#')
 			return handle_comment(stream);
-		else if (is_digit(chr))
-			return handle_numeric(stream);
-		else if (is_identifier_begin(chr))
-			return handle_keyword(stream);
 		else
-			return handle_operator(stream);
+			return handle_lexeme(stream);
 	}
 
-	token handle_comment(stream_info& stream) // peek = '#'
+	raw_token handle_comment(stream_info& stream) // peek = '#'
 	{
-		std::string content;
-		int line = stream.line();
-		int column = stream.column();
+		std::size_t offset = stream.offset();
+
+		stream.begin_lexeme();
+		stream.skip(scan_line);
+
+		if (stream.peek() == '\n')
+			stream.get();
 
-		while (stream.peek() != '\n')
-			content += stream.get();
+		std::string_view content = stream.end_lexeme();
 
-		stream.get();
+		if (content.back() == '\n')
+			content.remove_suffix(1);
 
-		return { std::move(content), token::kind::comment, line, column };
+		return { token::kind::comment, offset, content, {}, {}, 0 };
 	}
 
-	token handle_numeric(stream_info& stream) // is_digit(peek)
+	raw_token handle_lexeme(stream_info& stream) // operators, delimiters, numbers and identifiers
 	{
-		std::string content;
-		typename token::kind tokenKind;
-		int line = stream.line();
-		int column = stream.column();
-
-		content = read_integer(stream);
-
-		if (stream.peek() == '.') {
-			tokenKind = token::kind::literal_real;
-			content += stream.get();
-			content += read_integer(stream);
-		} else {
-			tokenKind = token::kind::literal_int;
+		lex_state state = lex_state::start;
+		std::size_t offset = stream.offset();
+
+		stream.begin_lexeme();
+
+		for (;;) {
+			auto chr = static_cast<unsigned char>(stream.peek());
+			lex_state next = transitions[static_cast<std::size_t>(state)][static_cast<std::size_t>(char_classes[chr])];
+
+			if (next == lex_state::reject)
+				break;
+
+			state = next;
+			stream.get();
+
+			if (state == lex_state::identifier)
+				stream.skip(scan_identifier);
 		}
 
-		if (stream.peek() == 'e' || stream.peek() == 'E') {
-			tokenKind = token::kind::literal_real;
-			content += stream.get();
+		const accept_info& info = accepts[static_cast<std::size_t>(state)];
+
+		if (!info.accepts) {
+			std::size_t errorOffset = info.error == lexical_error::kind::unexpected_symbol ? offset : stream.offset();
 
-			if (stream.peek() == '+' || stream.peek() == '-')
-				content += stream.get();
+			if (state == lex_state::start) // consume the unknown byte so lexing can resume after it
+				stream.get();
 
-			if (std::string exponent = read_integer(stream); exponent.size() > 0)
-				content += exponent;
-			else
-				throw lexical_error(lexical_error::kind::expected_exponent, stream.line(), stream.column());
+			return { token::kind::error, offset, stream.end_lexeme(), {}, info.error, errorOffset };
 		}
 
-		return { std::move(content), tokenKind, line, column };
-	}
+		raw_token raw{ info.type, offset, stream.end_lexeme(), {}, {}, offset };
 
-	token handle_keyword(stream_info& stream) // is_identifier_part(peek)
-	{
-		static const std::unordered_map<std::string, typename token::kind> keyword_map({
-			{ "true", token::kind::literal_true },
-			{ "false", token::kind::literal_false },
-			{ "none", token::kind::type_none },
-			{ "bool", token::kind::type_bool },
-			{ "int", token::kind::type_int },
-			{ "real", token::kind::type_real },
-			{ "mut", token::kind::modifier_mut },
-			{ "let", token::kind::keyword_let },
-			{ "fn", token::kind::keyword_fn },
-			{ "return", token::kind::keyword_return },
-			{ "end", token::kind::keyword_end },
-			{ "if", token::kind::keyword_if },
-			{ "elseif", token::kind::keyword_elseif },
-			{ "else", token::kind::keyword_else },
-			{ "then", token::kind::keyword_then },
-			{ "while", token::kind::keyword_while },
-			{ "for", token::kind::keyword_for },
-			{ "do", token::kind::keyword_do },
-			{ "break", token::kind::keyword_break },
-			{ "continue", token::kind::keyword_continue },
-			{ "not", token::kind::logical_not },
-			{ "and", token::kind::logical_and },
-			{ "or", token::kind::logical_or },
-			{ "type!", token::kind::intrinsic_type },
-			{ "line!", token::kind::intrinsic_line },
-			{ "column!", token::kind::intrinsic_column },
-			{ "dropmut!", token::kind::intrinsic_dropmut },
-			{ "dropref!", token::kind::intrinsic_dropref }
-		});
-
-		std::string content;
-		typename token::kind tokenKind;
-		int line = stream.line();
-		int column = stream.column();
-
-		while (is_identifier_part(stream.peek()))
-			content += stream.get();
-
-		if (stream.peek() == '!') // intrinsic
-			content += stream.get();
-
-		if (auto it = keyword_map.find(content); it != keyword_map.end())
-			tokenKind = it->second;
-		else if (content.back() != '!')
-			tokenKind = token::kind::identifier;
+		if (raw.type == token::kind::identifier)
+			classify_identifier(raw);
 		else
-			throw lexical_error(lexical_error::kind::unknown_intrinsic, line, column);
+			decode_literal(raw);
 
-		return { std::move(content), tokenKind, line, column };
+		return raw;
 	}
 
-	token handle_operator(stream_info& stream)
+	void classify_identifier(raw_token& raw) noexcept
 	{
-		static const std::unordered_map<std::string, typename token::kind> operator_map({
-			{ ",", token::kind::delimiter },
-			{ ":", token::kind::colon },
-			{ ";", token::kind::semicolon },
-			{ "(", token::kind::parenthesis_left },
-			{ ")", token::kind::parenthesis_right },
-			{ "&", token::kind::modifier_ref },
-			{ "+", token::kind::add },
-			{ "-", token::kind::subtract },
-			{ "*", token::kind::multiply },
-			{ "/", token::kind::divide },
-			{ "%", token::kind::remainder },
-			{ "=", token::kind::assign },
-			{ "+=", token::kind::assign_add },
-			{ "-=", token::kind::assign_subtract },
-			{ "*=", token::kind::assign_multiply },
-			{ "/=", token::kind::assign_divide },
-			{ "%=", token::kind::assign_remainder },
-			{ "==", token::kind::equal },
-			{ "!=", token::kind::not_equal },
-			{ "<", token::kind::less },
-			{ "<=", token::kind::less_or_equal },
-			{ ">", token::kind::greater },
-			{ ">=", token::kind::greater_or_equal }
-		});
-
-		std::string content;
-		typename token::kind tokenKind;
-		int line = stream.line();
-		int column = stream.column();
-
-		content += stream.get();
-		content += stream.peek();
-
-		if (auto it = operator_map.find(content); it != operator_map.end()) {
-			stream.get();
-			tokenKind = it->second;
-		} else {
-			content.pop_back();
-
-			if (auto it = operator_map.find(content); it != operator_map.end())
-				tokenKind = it->second;
-			else
-				throw lexical_error(lexical_error::kind::unexpected_symbol, line, column);
+		if (typename token::kind tokenKind = keyword_kind(raw.text); tokenKind != token::kind::identifier) {
+			raw.type = tokenKind;
+		} else if (raw.text.back() == '!') {
+			raw.type = token::kind::error;
+			raw.error = lexical_error::kind::unknown_intrinsic;
 		}
-
-		return { std::move(content), tokenKind, line, column };
 	}
 
-	char skip_whitespace(stream_info& stream)
+	void decode_literal(raw_token& raw) noexcept
 	{
-		while (is_whitespace(stream.peek()))
-			stream.get();
-
-		return stream.peek();
+		std::string_view content = raw.text;
+		std::from_chars_result result{};
+
+		if (raw.type == token::kind::literal_int)
+			result = std::from_chars(content.data(), content.data() + content.size(), raw.value.integer);
+		else if (raw.type == token::kind::literal_real)
+			result = std::from_chars(content.data(), content.data() + content.size(), raw.value.real);
+
+		if (result.ec == std::errc::result_out_of_range) {
+			// from_chars reports underflow the same way; a real too small to represent is zero
+			if (raw.type == token::kind::literal_int || decimal_magnitude(content) > 0) {
+				raw.type = token::kind::error;
+				raw.error = lexical_error::kind::literal_overflow;
+			} else {
+				raw.value.real = 0.0;
+			}
+		}
 	}
 
-	std::string read_integer(stream_info& stream)
+	int decimal_magnitude(std::string_view content) noexcept // position of the leading significant digit
 	{
-		std::string content;
+		std::size_t dot = content.find('.');
+		std::size_t exponent = content.find_first_of("eE");
+		std::size_t leading = content.find_first_of("123456789");
+		long magnitude = 0;
 
-		while (is_digit(stream.peek()))
-			content += stream.get();
+		dot = std::min(dot, exponent);
 
-		return content;
-	}
+		if (leading < dot)
+			magnitude = static_cast<long>(dot - leading);
+		else if (leading < exponent)
+			magnitude = -static_cast<long>(leading - dot - 1);
 
-	bool is_epsilon(char chr) noexcept
-	{
-		return chr == stream_info::eof;
-	}
+		if (exponent != std::string_view::npos) {
+			long scale = 0;
+			std::size_t digit = content.find_first_of("0123456789", exponent);
 
-	bool is_whitespace(char chr) noexcept
-	{
-		return chr == ' ' || chr == '\t' || chr == '\r' || chr == '\n';
+			for (; digit < content.size() && scale < 100000; ++digit)
+				scale = scale * 10 + (content[digit] - '0');
+
+			magnitude += content[exponent + 1] == '-' ? -scale : scale;
+		}
+
+		return static_cast<int>(magnitude);
 	}
 
-	bool is_character(char chr) noexcept
+	void raise(stream_info& stream, typename lexical_error::kind error, std::size_t offset)
 	{
-		return chr >= 0x20 && chr <= 0x7E;
+		auto [line, column] = stream.locate(offset);
+		throw lexical_error(error, line, column);
 	}
 
-	bool is_newline(char chr) noexcept
+	char skip_whitespace(stream_info& stream)
 	{
-		return chr == '\r' || chr == '\n';
+		stream.skip(scan_whitespace);
+
+		return stream.peek();
 	}
 
-	bool is_digit(char chr) noexcept
+	bool is_epsilon(char chr) noexcept
 	{
-		return chr >= '0' && chr <= '9';
+		return chr == stream_info::eof;
 	}
 
-	bool is_identifier_begin(char chr) noexcept
+	bool is_character(char chr) noexcept
 	{
-		return (chr >= 'A' && chr <= 'Z') || (chr >= 'a' && chr <= 'z') || chr == '_';
+		return chr >= 0x20 && chr <= 0x7E;
 	}
 
-	bool is_identifier_part(char chr) noexcept
+	bool is_newline(char chr) noexcept
 	{
-		return is_identifier_begin(chr) || is_digit(chr);
+		return chr == '\r' || chr == '\n';
 	}
 }
@@ -0,0 +1,244 @@
+#include "type_table.hpp"
+
+using namespace cntlang;
+
+type_table::type_table(std::size_t expectedSignatures)
+{
+	std::size_t capacity = 16;
+
+	while (capacity < expectedSignatures * 2)
+		capacity *= 2;
+
+	m_parameters.reserve(expectedSignatures * 4);
+	m_signatures.reserve(expectedSignatures);
+	m_slots.resize(capacity);
+	m_scratch.reserve(64);
+}
+
+std::uint32_t type_table::function(std::uint32_t result, const std::uint32_t* parameters, std::uint32_t count)
+{
+	std::uint32_t interned = find(result, parameters, count);
+
+	if (interned != not_found || sentinel(result, parameters, count) == not_found)
+		return interned;
+
+	std::uint32_t hashed = hash(result, parameters, count);
+	std::size_t mask = m_slots.size() - 1;
+	std::size_t slot = hashed & mask;
+
+	while (m_slots[slot] != 0) // find() came this way, only the empty slot is left
+		slot = (slot + 1) & mask;
+
+	auto index = static_cast<std::uint32_t>(m_signatures.size());
+
+	m_signatures.push_back({ static_cast<std::uint32_t>(m_parameters.size()), count, hashed });
+	m_parameters.push_back(result);
+	m_parameters.insert(m_parameters.end(), parameters, parameters + count);
+	m_slots[slot] = index + 1;
+
+	if (m_signatures.size() * 2 > m_slots.size())
+		grow();
+
+	return first_function + (index << modifier_bits);
+}
+
+std::uint32_t type_table::find(std::uint32_t result, const std::uint32_t* parameters, std::uint32_t count) const noexcept
+{
+	if (std::uint32_t failed = sentinel(result, parameters, count))
+		return failed;
+
+	std::uint32_t hashed = hash(result, parameters, count);
+	std::size_t mask = m_slots.size() - 1;
+
+	for (std::size_t slot = hashed & mask;; slot = (slot + 1) & mask) {
+		std::uint32_t entry = m_slots[slot];
+
+		if (entry == 0)
+			return not_found;
+
+		const signature& candidate = m_signatures[entry - 1];
+
+		if (candidate.hashed != hashed || candidate.count != count || m_parameters[candidate.first] != result)
+			continue;
+
+		const std::uint32_t* existing = m_parameters.data() + candidate.first + 1;
+		std::uint32_t i = 0;
+
+		while (i < count && existing[i] == parameters[i])
+			++i;
+
+		if (i == count)
+			return first_function + ((entry - 1) << modifier_bits);
+	}
+}
+
+std::uint32_t type_table::intern(const ast& tree, const token_buffer& tokens, std::uint32_t type, const std::uint32_t* deduced)
+{
+	return walk(tree, tokens, type, deduced, m_scratch, [this](std::uint32_t result, const std::uint32_t* parameters, std::uint32_t count) {
+		return function(result, parameters, count);
+	});
+}
+
+std::uint32_t type_table::find(const ast& tree, const token_buffer& tokens, std::uint32_t type, const std::uint32_t* deduced, std::vector<std::uint32_t>& scratch) const
+{
+	return walk(tree, tokens, type, deduced, scratch, [this](std::uint32_t result, const std::uint32_t* parameters, std::uint32_t count) {
+		return find(result, parameters, count);
+	});
+}
+
+template<typename Signature>
+std::uint32_t type_table::walk(const ast& tree, const token_buffer& tokens, std::uint32_t type, const std::uint32_t* deduced, std::vector<std::uint32_t>& scratch, Signature&& signature)
+{
+	const node& entry = tree[type];
+
+	if (entry.type == node::kind::function_type) { // the return type, then the parameters
+		std::size_t mark = scratch.size();
+		std::uint32_t result = walk(tree, tokens, tree.child(type, 0), deduced, scratch, signature);
+
+		for (std::uint32_t i = 1; i < entry.count; ++i) {
+			std::uint32_t parameter = walk(tree, tokens, tree.child(type, i), deduced, scratch, signature); // may push and pop nested signatures
+
+			scratch.push_back(parameter);
+		}
+
+		std::uint32_t interned = signature(result, scratch.data() + mark, entry.count - 1);
+
+		scratch.resize(mark);
+
+		return interned;
+	}
+
+	if (entry.type != node::kind::type)
+		return unknown;
+
+	std::uint32_t modifiers = 0;
+	std::uint32_t modified = 0;
+
+	for (; modified < entry.count && tree[tree.child(type, modified)].type == node::kind::terminal; ++modified)
+		modifiers |= tokens.type(tree.token(tree.child(type, modified))) == token::kind::modifier_mut ? mutable_flag : reference_flag;
+
+	switch (tokens.type(tree.token(type))) {
+	case token::kind::type_none: return modifiers ? invalid : none;
+	case token::kind::type_bool: return qualify(boolean, modifiers);
+	case token::kind::type_int: return qualify(integer, modifiers);
+	case token::kind::type_real: return qualify(real, modifiers);
+	case token::kind::intrinsic_dropmut: return qualify(dropmut(walk(tree, tokens, tree.child(type, modified), deduced, scratch, signature)), modifiers);
+	case token::kind::intrinsic_dropref: return qualify(dropref(walk(tree, tokens, tree.child(type, modified), deduced, scratch, signature)), modifiers);
+	case token::kind::intrinsic_type: { // the deduced type of its expression, which must have one
+		std::uint32_t expression = deduced ? deduced[tree.child(type, modified)] : unknown;
+
+		return qualify(expression == none ? invalid : expression, modifiers);
+	}
+	default: return unknown;
+	}
+}
+
+std::uint32_t type_table::qualify(std::uint32_t type, std::uint32_t modifiers) noexcept
+{
+	if (modifiers == 0 || base(type) >= not_found)
+		return type;
+
+	if (!is_complete(type) || is_function(type))
+		return invalid;
+
+	return type | modifiers;
+}
+
+std::uint32_t type_table::result(std::uint32_t function) const noexcept
+{
+	return m_parameters[entry(function).first];
+}
+
+std::uint32_t type_table::parameter_count(std::uint32_t function) const noexcept
+{
+	return entry(function).count;
+}
+
+const std::uint32_t* type_table::parameters(std::uint32_t function) const noexcept
+{
+	return m_parameters.data() + entry(function).first + 1;
+}
+
+std::uint32_t type_table::size() const noexcept
+{
+	return static_cast<std::uint32_t>(m_signatures.size()) + (first_function >> modifier_bits);
+}
+
+std::string type_table::name(std::uint32_t type) const
+{
+	if (base(type) == invalid)
+		return "<invalid>";
+
+	if (base(type) >= not_found)
+		return "<unknown>";
+
+	std::string text;
+
+	if (is_mutable(type))
+		text += "mut ";
+
+	if (is_reference(type))
+		text += '&';
+
+	switch (base(type)) {
+	case none: return text + "none";
+	case boolean: return text + "bool";
+	case integer: return text + "int";
+	case real: return text + "real";
+	default:
+		break;
+	}
+
+	text += name(result(type)) + '(';
+
+	for (std::uint32_t i = 0; i < parameter_count(type); ++i)
+		text += (i ? ", " : "") + name(parameters(type)[i]);
+
+	return text + ')';
+}
+
+std::uint32_t type_table::sentinel(std::uint32_t result, const std::uint32_t* parameters, std::uint32_t count) noexcept
+{
+	std::uint32_t failed = base(result) >= not_found ? base(result) : 0;
+
+	for (std::uint32_t i = 0; i < count; ++i) {
+		std::uint32_t parameter = is_complete(parameters[i]) || base(parameters[i]) >= not_found ? base(parameters[i]) : invalid; // none
+
+		if (parameter >= not_found && (failed == 0 || parameter < failed))
+			failed = parameter;
+	}
+
+	return failed; // not_found first, so a read-only lookup is retried rather than reported
+}
+
+std::uint32_t type_table::hash(std::uint32_t result, const std::uint32_t* parameters, std::uint32_t count) noexcept // FNV-1a over the ids
+{
+	std::uint32_t hashed = (2166136261u ^ result) * 16777619u;
+
+	for (std::uint32_t i = 0; i < count; ++i)
+		hashed = (hashed ^ parameters[i]) * 16777619u;
+
+	return (hashed ^ (hashed >> 15)) * 2246822519u; // the ids differ in few bits, spread them over the slot index
+}
+
+const type_table::signature& type_table::entry(std::uint32_t function) const noexcept
+{
+	return m_signatures[(base(function) - first_function) >> modifier_bits];
+}
+
+void type_table::grow()
+{
+	std::vector<std::uint32_t> slots(m_slots.size() * 2);
+	std::size_t mask = slots.size() - 1;
+
+	for (std::uint32_t index = 0; index < m_signatures.size(); ++index) {
+		std::size_t slot = m_signatures[index].hashed & mask;
+
+		while (slots[slot] != 0)
+			slot = (slot + 1) & mask;
+
+		slots[slot] = index + 1;
+	}
+
+	m_slots = std::move(slots);
+}
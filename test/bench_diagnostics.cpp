@@ -0,0 +1,47 @@
+#include <iostream>
+#include "support.hpp"
+#include "token_buffer.hpp"
+
+using namespace cntlang;
+
+// Lexing a source with an error every few lines: the reporting lexer in one pass, against the throwing lexer
+// restarted past each error it throws, which is how every error was found before.
+int main(int argc, char** argv)
+{
+	std::string unit = support::read_file("test/lexical_units.cnt") + "let x: int = 1e;\nfoo! y @ z\n";
+	std::string contents = support::repeat(unit, support::megabytes(argc, argv, 16));
+	std::size_t reported = 0;
+	std::size_t thrown = 0;
+
+	double reporting = support::best_of(3, [&]() {
+		stream_info stream(contents);
+		interner symbols;
+		std::vector<lexical_diagnostic> diagnostics;
+
+		diagnostics.reserve(1 << 16);
+
+		while (next_token(stream, symbols, diagnostics).type != token::kind::end_of_stream) {
+		}
+
+		reported = diagnostics.size();
+	});
+	double throwing = support::best_of(3, [&]() {
+		stream_info stream(contents);
+		interner symbols;
+
+		for (thrown = 0;;) {
+			try {
+				if (next_token(stream, symbols).type == token::kind::end_of_stream)
+					break;
+			} catch (const lexical_error&) { // the stream is past the offending lexeme
+				++thrown;
+			}
+		}
+	});
+
+	std::cout << "lexical errors, " << (contents.size() >> 20) << " MiB with " << reported << " errors (" << thrown << " thrown)\n"
+		<< "  reported           " << support::mib_per_second(contents.size(), reporting) << " MiB/s\n"
+		<< "  thrown, caught     " << support::mib_per_second(contents.size(), throwing) << " MiB/s\n";
+
+	return 0;
+}
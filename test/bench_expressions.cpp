@@ -0,0 +1,71 @@
+#include <iostream>
+#include "parser.hpp"
+#include "support.hpp"
+
+using namespace cntlang;
+
+namespace
+{
+	std::string chains(std::size_t bytes) // long binary operator chains over every precedence level
+	{
+		std::string chain;
+		std::string contents;
+
+		for (int index = 0; index < 64; ++index)
+			chain += "1 + 2 * 3 - 4 / 5 % 6 < 7 == 8 > 9 and ";
+
+		for (std::size_t index = 0; contents.size() < bytes; ++index)
+			contents += "let c" + std::to_string(index) + ": int = " + chain + "0;\n";
+
+		return contents;
+	}
+
+	std::string nesting(std::size_t bytes) // parentheses and unary operators 256 deep
+	{
+		std::string nest;
+		std::string contents;
+
+		for (int depth = 0; depth < 256; ++depth)
+			nest += "-(1 + ";
+
+		nest += '0';
+
+		for (int depth = 0; depth < 256; ++depth)
+			nest += ')';
+
+		for (std::size_t index = 0; contents.size() < bytes; ++index)
+			contents += "let n" + std::to_string(index) + ": int = " + nest + ";\n";
+
+		return contents;
+	}
+
+	void run(const char* name, const std::string& contents)
+	{
+		interner symbols;
+		stream_info stream(contents);
+		token_buffer tokens = tokenize(stream, symbols);
+		std::size_t nodes = 0;
+
+		double seconds = support::best_of(3, [&]() {
+			parser parser(tokens, symbols);
+
+			nodes = parser.parse().size();
+		});
+
+		std::cout << "  " << name << ": " << support::mib_per_second(contents.size(), seconds) << " MiB/s, "
+			<< nodes << " nodes for " << tokens.size() << " tokens, " << double(nodes) / tokens.size() << " per token\n";
+	}
+}
+
+// Parsing pre-lexed programs made of deep expressions: one node per operator and operand, whatever the depth
+// of the grammar, keeps nodes per token below one.
+int main(int argc, char** argv)
+{
+	std::size_t bytes = support::megabytes(argc, argv, 16);
+
+	std::cout << "expressions, " << (bytes >> 20) << " MiB\n";
+	run("operator chains", chains(bytes));
+	run("nested parentheses", nesting(bytes));
+
+	return 0;
+}
@@ -0,0 +1,38 @@
+#include <iostream>
+#include "parser.hpp"
+#include "support.hpp"
+
+using namespace cntlang;
+
+// The hand-written parser against parse_generated, which walks the LL(1) tables, on the same pre-lexed program.
+int main(int argc, char** argv)
+{
+	std::string contents = support::program(support::megabytes(argc, argv, 32));
+	interner symbols;
+	stream_info stream(contents);
+	token_buffer tokens = tokenize(stream, symbols);
+	ast hand;
+	ast generated;
+
+	double handwritten = support::best_of(3, [&]() {
+		parser parser(tokens, symbols);
+
+		hand = parser.parse();
+	});
+	double tables = support::best_of(3, [&]() {
+		parser parser(tokens, symbols);
+
+		generated = parser.parse_generated();
+	});
+
+	std::cout << "generated parser, " << (contents.size() >> 20) << " MiB, " << hand.size() << " nodes\n"
+		<< "  hand-written  " << support::mib_per_second(contents.size(), handwritten) << " MiB/s\n"
+		<< "  LL(1) tables  " << support::mib_per_second(contents.size(), tables) << " MiB/s\n";
+
+	if (!support::same_tree(hand, generated)) {
+		std::cerr << "bench_generated: the trees differ\n";
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,218 @@
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include "support.hpp"
+#include "tokenizer.hpp"
+
+using namespace cntlang;
+
+// The lexer as it was before the DFA: punctuation looked up in a string map, two characters then one.
+namespace baseline
+{
+	bool is_digit(char chr) noexcept
+	{
+		return chr >= '0' && chr <= '9';
+	}
+
+	bool is_identifier_begin(char chr) noexcept
+	{
+		return (chr >= 'A' && chr <= 'Z') || (chr >= 'a' && chr <= 'z') || chr == '_';
+	}
+
+	bool is_identifier_part(char chr) noexcept
+	{
+		return is_identifier_begin(chr) || is_digit(chr);
+	}
+
+	std::size_t read_integer(stream_info& stream)
+	{
+		std::size_t count = 0;
+
+		for (; is_digit(stream.peek()); ++count)
+			stream.get();
+
+		return count;
+	}
+
+	token handle_comment(stream_info& stream)
+	{
+		auto [line, column] = stream.locate();
+
+		stream.begin_lexeme();
+
+		while (stream.peek() != '\n' && stream.peek() != stream_info::eof)
+			stream.get();
+
+		std::string content(stream.end_lexeme());
+
+		stream.get();
+		return { std::move(content), token::kind::comment, line, column, {} };
+	}
+
+	token handle_numeric(stream_info& stream)
+	{
+		typename token::kind tokenKind = token::kind::literal_int;
+		auto [line, column] = stream.locate();
+
+		stream.begin_lexeme();
+		read_integer(stream);
+
+		if (stream.peek() == '.') {
+			tokenKind = token::kind::literal_real;
+			stream.get();
+			read_integer(stream);
+		}
+
+		if (stream.peek() == 'e' || stream.peek() == 'E') {
+			tokenKind = token::kind::literal_real;
+			stream.get();
+
+			if (stream.peek() == '+' || stream.peek() == '-')
+				stream.get();
+
+			if (read_integer(stream) == 0) {
+				position where = stream.locate();
+				throw lexical_error(lexical_error::kind::expected_exponent, where.line, where.column);
+			}
+		}
+
+		return { std::string(stream.end_lexeme()), tokenKind, line, column, {} };
+	}
+
+	token handle_keyword(stream_info& stream)
+	{
+		static const std::unordered_map<std::string, typename token::kind> keyword_map({
+			{ "true", token::kind::literal_true }, { "false", token::kind::literal_false },
+			{ "none", token::kind::type_none }, { "bool", token::kind::type_bool },
+			{ "int", token::kind::type_int }, { "real", token::kind::type_real },
+			{ "mut", token::kind::modifier_mut }, { "let", token::kind::keyword_let },
+			{ "fn", token::kind::keyword_fn }, { "return", token::kind::keyword_return },
+			{ "end", token::kind::keyword_end }, { "if", token::kind::keyword_if },
+			{ "elseif", token::kind::keyword_elseif }, { "else", token::kind::keyword_else },
+			{ "then", token::kind::keyword_then }, { "while", token::kind::keyword_while },
+			{ "for", token::kind::keyword_for }, { "do", token::kind::keyword_do },
+			{ "break", token::kind::keyword_break }, { "continue", token::kind::keyword_continue },
+			{ "not", token::kind::logical_not }, { "and", token::kind::logical_and },
+			{ "or", token::kind::logical_or }, { "type!", token::kind::intrinsic_type },
+			{ "line!", token::kind::intrinsic_line }, { "column!", token::kind::intrinsic_column },
+			{ "dropmut!", token::kind::intrinsic_dropmut }, { "dropref!", token::kind::intrinsic_dropref }
+		});
+
+		typename token::kind tokenKind;
+		auto [line, column] = stream.locate();
+
+		stream.begin_lexeme();
+
+		while (is_identifier_part(stream.peek()))
+			stream.get();
+
+		if (stream.peek() == '!')
+			stream.get();
+
+		std::string content(stream.end_lexeme());
+
+		if (auto it = keyword_map.find(content); it != keyword_map.end())
+			tokenKind = it->second;
+		else if (content.back() != '!')
+			tokenKind = token::kind::identifier;
+		else
+			throw lexical_error(lexical_error::kind::unknown_intrinsic, line, column);
+
+		return { std::move(content), tokenKind, line, column, {} };
+	}
+
+	token handle_operator(stream_info& stream)
+	{
+		static const std::unordered_map<std::string, typename token::kind> operator_map({
+			{ ",", token::kind::delimiter }, { ":", token::kind::colon }, { ";", token::kind::semicolon },
+			{ "(", token::kind::parenthesis_left }, { ")", token::kind::parenthesis_right },
+			{ "&", token::kind::modifier_ref }, { "+", token::kind::add }, { "-", token::kind::subtract },
+			{ "*", token::kind::multiply }, { "/", token::kind::divide }, { "%", token::kind::remainder },
+			{ "=", token::kind::assign }, { "+=", token::kind::assign_add }, { "-=", token::kind::assign_subtract },
+			{ "*=", token::kind::assign_multiply }, { "/=", token::kind::assign_divide },
+			{ "%=", token::kind::assign_remainder }, { "==", token::kind::equal }, { "!=", token::kind::not_equal },
+			{ "<", token::kind::less }, { "<=", token::kind::less_or_equal },
+			{ ">", token::kind::greater }, { ">=", token::kind::greater_or_equal }
+		});
+
+		std::string content;
+		typename token::kind tokenKind;
+		auto [line, column] = stream.locate();
+
+		content += stream.get();
+		content += stream.peek();
+
+		if (auto it = operator_map.find(content); it != operator_map.end()) {
+			stream.get();
+			tokenKind = it->second;
+		} else {
+			content.pop_back();
+
+			if (auto it = operator_map.find(content); it != operator_map.end())
+				tokenKind = it->second;
+			else
+				throw lexical_error(lexical_error::kind::unexpected_symbol, line, column);
+		}
+
+		return { std::move(content), tokenKind, line, column, {} };
+	}
+
+	token next_token(stream_info& stream)
+	{
+		while (stream.peek() == ' ' || stream.peek() == '\t' || stream.peek() == '\r' || stream.peek() == '\n')
+			stream.get();
+
+		char chr = stream.peek();
+
+		if (chr == stream_info::eof) {
+			auto [line, column] = stream.locate();
+			return { "<end-of-stream>", token::kind::end_of_stream, line, column, {} };
+		} else if (chr == '#')
+			return handle_comment(stream);
+		else if (is_digit(chr))
+			return handle_numeric(stream);
+		else if (is_identifier_begin(chr))
+			return handle_keyword(stream);
+		else
+			return handle_operator(stream);
+	}
+}
+
+// Throughput of the table-driven lexer against the string-map baseline, on test/lexical_units.cnt scaled up.
+int main(int argc, char** argv)
+{
+	std::string contents = support::repeat(support::read_file("test/lexical_units.cnt"), support::megabytes(argc, argv, 100));
+	std::size_t counts[3] = {};
+
+	double map = support::best_of(3, [&]() {
+		stream_info stream(contents);
+
+		for (counts[0] = 1; baseline::next_token(stream).type != token::kind::end_of_stream; ++counts[0]) {
+		}
+	});
+	double strings = support::best_of(3, [&]() {
+		stream_info stream(contents);
+
+		for (counts[1] = 1; next_token(stream).type != token::kind::end_of_stream; ++counts[1]) {
+		}
+	});
+	double views = support::best_of(3, [&]() {
+		stream_info stream(contents);
+		interner symbols;
+
+		for (counts[2] = 1; next_token(stream, symbols).type != token::kind::end_of_stream; ++counts[2]) {
+		}
+	});
+
+	if (counts[0] != counts[1] || counts[1] != counts[2]) {
+		std::cerr << "token counts differ: " << counts[0] << ", " << counts[1] << ", " << counts[2] << "\n";
+		return 1;
+	}
+
+	std::cout << "lexer, " << (contents.size() >> 20) << " MiB of test/lexical_units.cnt, " << counts[0] << " tokens\n"
+		<< "  string maps          " << support::mib_per_second(contents.size(), map) << " MiB/s\n"
+		<< "  DFA, token           " << support::mib_per_second(contents.size(), strings) << " MiB/s\n"
+		<< "  DFA, token_view      " << support::mib_per_second(contents.size(), views) << " MiB/s\n";
+
+	return 0;
+}
@@ -0,0 +1,39 @@
+#include <iostream>
+#include <thread>
+#include "support.hpp"
+#include "token_buffer.hpp"
+
+using namespace cntlang;
+
+// tokenize_parallel against tokenize on generated programs, by thread count; the speedup is bounded by the
+// cores of the machine, which is printed first.
+int main(int argc, char** argv)
+{
+	std::size_t largest = support::megabytes(argc, argv, 64);
+
+	std::cout << "tokenize_parallel, " << std::thread::hardware_concurrency() << " hardware threads\n";
+
+	for (std::size_t bytes = 1 << 20; bytes <= largest; bytes *= 4) {
+		std::string contents = support::program(bytes);
+		double serial = support::best_of(5, [&contents]() {
+			stream_info stream(contents);
+			interner symbols;
+			tokenize(stream, symbols);
+		});
+
+		std::cout << "  " << (contents.size() >> 20) << " MiB: serial " << support::mib_per_second(contents.size(), serial) << " MiB/s";
+
+		for (unsigned threads : { 2, 4, 8 }) {
+			double parallel = support::best_of(5, [&contents, threads]() {
+				interner symbols;
+				tokenize_parallel(contents, symbols, threads);
+			});
+
+			std::cout << ", " << threads << " threads " << serial / parallel << "x";
+		}
+
+		std::cout << '\n';
+	}
+
+	return 0;
+}
@@ -0,0 +1,46 @@
+#include <iostream>
+#include <thread>
+#include "parser.hpp"
+#include "support.hpp"
+
+using namespace cntlang;
+
+// Parsing a pre-lexed program serially against in parallel over its top-level definitions, by thread count, on
+// generated programs of thousands of functions; the speedup is bounded by the cores of the machine.
+int main(int argc, char** argv)
+{
+	std::size_t largest = support::megabytes(argc, argv, 64);
+
+	std::cout << "parallel parse, " << std::thread::hardware_concurrency() << " hardware threads\n";
+
+	for (std::size_t bytes = 1 << 20; bytes <= largest; bytes *= 4) {
+		std::string contents = support::program(bytes);
+		interner symbols;
+		stream_info stream(contents);
+		token_buffer tokens = tokenize(stream, symbols);
+		std::size_t functions = 0;
+
+		double serial = support::best_of(5, [&]() {
+			parser parser(tokens, symbols);
+
+			functions = parser.parse()[parser.tree().root()].count;
+		});
+
+		std::cout << "  " << (contents.size() >> 20) << " MiB, " << functions << " definitions: serial "
+			<< support::mib_per_second(contents.size(), serial) << " MiB/s";
+
+		for (unsigned threads : { 2, 4, 8 }) {
+			double parallel = support::best_of(5, [&tokens, &symbols, threads]() {
+				parser parser(tokens, symbols, threads);
+
+				parser.parse();
+			});
+
+			std::cout << ", " << threads << " threads " << serial / parallel << "x";
+		}
+
+		std::cout << '\n';
+	}
+
+	return 0;
+}
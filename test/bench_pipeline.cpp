@@ -0,0 +1,42 @@
+#include <iostream>
+#include <thread>
+#include "parser.hpp"
+#include "support.hpp"
+
+using namespace cntlang;
+
+// Parsing a generated program lexed on the same thread, against lexed on a producer thread through the token
+// ring; the overlap needs a second core, so the hardware threads are printed first.
+int main(int argc, char** argv)
+{
+	std::string contents = support::program(support::megabytes(argc, argv, 32));
+	std::size_t serial_nodes = 0;
+	std::size_t pipelined_nodes = 0;
+
+	double serial = support::best_of(3, [&]() {
+		stream_info stream(contents);
+		interner symbols;
+		parser parser(stream, symbols);
+
+		serial_nodes = parser.parse().size();
+	});
+	double pipelined = support::best_of(3, [&]() {
+		stream_info stream(contents);
+		interner symbols;
+		token_pipeline tokens(stream, symbols);
+		parser parser(tokens, symbols);
+
+		pipelined_nodes = parser.parse().size();
+	});
+
+	std::cout << "token_pipeline, " << (contents.size() >> 20) << " MiB, " << std::thread::hardware_concurrency() << " hardware threads\n"
+		<< "  serial     " << support::mib_per_second(contents.size(), serial) << " MiB/s\n"
+		<< "  pipelined  " << support::mib_per_second(contents.size(), pipelined) << " MiB/s\n";
+
+	if (serial_nodes != pipelined_nodes) {
+		std::cerr << "bench_pipeline: " << serial_nodes << " nodes serially, " << pipelined_nodes << " pipelined\n";
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,72 @@
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <unistd.h>
+#include "mapped_file.hpp"
+#include "support.hpp"
+#include "token_buffer.hpp"
+
+using namespace cntlang;
+
+// stream_info served from a mapped file against the istream fallback, on test/lexical_units.cnt scaled up;
+// the bare std::istream::get() loop is what every character cost before.
+int main(int argc, char** argv)
+{
+	std::string contents = support::repeat(support::read_file("test/lexical_units.cnt"), support::megabytes(argc, argv, 64));
+	char path[] = "/tmp/cntlang_bench_XXXXXX";
+	int fd = ::mkstemp(path);
+
+	if (fd < 0 || ::write(fd, contents.data(), contents.size()) != static_cast<ssize_t>(contents.size())) {
+		std::cerr << "could not write " << path << "!\n";
+		return 1;
+	}
+
+	::close(fd);
+
+	volatile std::size_t sink = 0; // keeps the loops from being optimized away
+	auto characters = [&sink](stream_info& stream) {
+		for (char c = stream.get(); c != stream_info::eof; c = stream.get())
+			sink += static_cast<unsigned char>(c);
+	};
+	auto tokens = [&sink](stream_info& stream) {
+		interner symbols;
+		sink += tokenize(stream, symbols).size();
+	};
+
+	double get = support::best_of(3, [&]() {
+		std::ifstream file(path, std::ios::binary);
+
+		for (int c = file.get(); c != std::ifstream::traits_type::eof(); c = file.get())
+			sink += c;
+	});
+	double mappedGet = support::best_of(3, [&]() {
+		mapped_file mapping(path);
+		stream_info stream(mapping.contents(), path);
+		characters(stream);
+	});
+	double streamedGet = support::best_of(3, [&]() {
+		std::ifstream file(path, std::ios::binary);
+		stream_info stream(file, path);
+		characters(stream);
+	});
+	double mappedLex = support::best_of(3, [&]() {
+		mapped_file mapping(path);
+		stream_info stream(mapping.contents(), path);
+		tokens(stream);
+	});
+	double streamedLex = support::best_of(3, [&]() {
+		std::ifstream file(path, std::ios::binary);
+		stream_info stream(file, path);
+		tokens(stream);
+	});
+
+	std::remove(path);
+	std::cout << "stream_info, " << (contents.size() >> 20) << " MiB of test/lexical_units.cnt\n"
+		<< "  std::istream::get   " << support::mib_per_second(contents.size(), get) << " MiB/s\n"
+		<< "  get, mapped         " << support::mib_per_second(contents.size(), mappedGet) << " MiB/s\n"
+		<< "  get, istream        " << support::mib_per_second(contents.size(), streamedGet) << " MiB/s\n"
+		<< "  tokenize, mapped    " << support::mib_per_second(contents.size(), mappedLex) << " MiB/s\n"
+		<< "  tokenize, istream   " << support::mib_per_second(contents.size(), streamedLex) << " MiB/s\n";
+
+	return 0;
+}
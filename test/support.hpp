@@ -0,0 +1,133 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include "ast.hpp"
+#include "token_buffer.hpp"
+
+// Corpora and timing shared by the benchmarks and tests under test/.
+namespace cntlang::support
+{
+	inline std::string read_file(const std::string& path)
+	{
+		std::ifstream file(path, std::ios::binary);
+
+		if (!file)
+			throw std::runtime_error("could not open " + path);
+
+		return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	}
+
+	inline std::string repeat(std::string unit, std::size_t bytes) // copies of unit, each on lines of its own
+	{
+		std::string contents;
+
+		if (unit.empty() || unit.back() != '\n')
+			unit += '\n';
+
+		contents.reserve(bytes + unit.size());
+
+		while (contents.size() < bytes)
+			contents += unit;
+
+		return contents;
+	}
+
+	inline std::string program(std::size_t bytes) // a valid program of about that size: many small functions over a few globals
+	{
+		std::string contents = "let gi: mut int = 0;\nlet gr: mut real = 1.5;\nlet cb: real(real, real) = f0;\n";
+
+		contents.reserve(bytes + 512);
+
+		for (std::size_t index = 0; contents.size() < bytes; ++index) {
+			contents += "fn f" + std::to_string(index) + "(a: real, b: real): real\n"
+				"\tlet s: mut real = a;\n"
+				"\tfor let k: mut int = 0, 10 do\n"
+				"\t\tif k % 3 == 0 then s += b * k; elseif k > 7 then break; else continue; end\n"
+				"\tend\n"
+				"\twhile s > 100.0 do s = s / 2; end\n"
+				"\tlet h: real(real, real) = f" + std::to_string(index == 0 ? 0 : index - 1) + ";\n"
+				"\tgi += 1;\n"
+				"\treturn h(s, cb(a, 2)) + gr;\n"
+				"end\n";
+		}
+
+		return contents;
+	}
+
+	inline std::size_t megabytes(int argc, char** argv, std::size_t fallback) // from the first argument, in MiB
+	{
+		return (argc > 1 ? std::strtoull(argv[1], nullptr, 10) : fallback) << 20;
+	}
+
+	// Same shape, tokens and bindings; node indices may differ, as after a reparse or a lazy body.
+	inline bool same_tree(const ast& left, std::uint32_t x, const ast& right, std::uint32_t y)
+	{
+		if (left[x].type != right[y].type || left.token(x) != right.token(y) || left[x].count != right[y].count)
+			return false;
+
+		std::uint32_t from = left.binding(x);
+		std::uint32_t to = right.binding(y);
+
+		if ((from == ast::dummy) != (to == ast::dummy) || left.token(from) != right.token(to) || left[from].type != right[to].type)
+			return false;
+
+		for (std::uint32_t nth = 0; nth < left[x].count; ++nth) {
+			if (!same_tree(left, left.child(x, nth), right, right.child(y, nth)))
+				return false;
+		}
+
+		return true;
+	}
+
+	inline bool same_tree(const ast& left, const ast& right)
+	{
+		return same_tree(left, left.root(), right, right.root());
+	}
+
+	inline bool same_tokens(const token_buffer& left, const token_buffer& right) // and line starts
+	{
+		if (left.size() != right.size() || left.lines().size() != right.lines().size())
+			return false;
+
+		for (std::uint32_t index = 0; index < left.size(); ++index) {
+			if (left.type(index) != right.type(index) || left.offset(index) != right.offset(index)
+				|| left.length(index) != right.length(index) || left.payload(index) != right.payload(index))
+				return false;
+		}
+
+		for (std::size_t line = 1; line <= left.lines().size(); ++line) {
+			if (left.lines().line_start(line) != right.lines().line_start(line))
+				return false;
+		}
+
+		return true;
+	}
+
+	template<typename Work>
+	double best_of(int runs, Work&& work) // wall time of the fastest run, in seconds
+	{
+		double best = 1e300;
+
+		for (int run = 0; run < runs; ++run) {
+			auto start = std::chrono::steady_clock::now();
+
+			work();
+
+			std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+			best = std::min(best, elapsed.count());
+		}
+
+		return best;
+	}
+
+	inline double mib_per_second(std::size_t bytes, double seconds) noexcept
+	{
+		return bytes / seconds / (1024 * 1024);
+	}
+}
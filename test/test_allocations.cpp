@@ -0,0 +1,55 @@
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include "support.hpp"
+#include "tokenizer.hpp"
+
+namespace
+{
+	std::size_t allocations = 0;
+}
+
+void* operator new(std::size_t size)
+{
+	++allocations;
+
+	if (void* memory = std::malloc(size == 0 ? 1 : size))
+		return memory;
+
+	throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+	std::free(memory);
+}
+
+using namespace cntlang;
+
+// Lexing a memory-backed source into token views allocates nothing per token: lexemes are ranges of the source
+// and identifiers go to an interner sized up front.
+int main()
+{
+	std::string contents = support::repeat(support::read_file("test/lexical_units.cnt"), 16 << 20);
+	stream_info stream(contents, "test/lexical_units.cnt");
+	interner symbols;
+	std::size_t tokens = 1;
+	std::size_t before = allocations;
+
+	while (next_token(stream, symbols).type != token::kind::end_of_stream)
+		++tokens;
+
+	std::size_t allocated = allocations - before;
+
+	if (tokens < 1000000 || allocated != 0) {
+		std::cerr << "test_allocations: " << allocated << " allocations lexing " << tokens << " tokens\n";
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,105 @@
+#include <iostream>
+#include <random>
+#include "parser.hpp"
+#include "support.hpp"
+
+using namespace cntlang;
+
+namespace
+{
+	// every rule of doc/parser_rules.ebnf, whether or not it type-checks
+	const char* const coverage =
+		"let a: int = 1;\n"
+		"let b: mut real = 2.5e3;\n"
+		"let c: & mut int(bool, real)(int) = f;\n"
+		"let d: dropmut! mut int = a;\n"
+		"let e: dropref! & int = a;\n"
+		"let t: type! (a + 1) = 2;\n"
+		"let u: bool;\n"
+		"fn none_(): none end\n"
+		"fn f(x: int, y: mut real, z: none(int)): int(int)\n"
+		"\tlet v: int = -x * (y + 1) / 2 % 3 - not true;\n"
+		"\tv = x += y -= 1 *= 2 /= 3 %= 4;\n"
+		"\tif x < 1 and y <= 2 or x > 3 then return; elseif x >= 4 then v = 1; elseif x == 5 then else break; end\n"
+		"\twhile x != 0 do continue; end\n"
+		"\tfor let i: mut int = 0, 10, 2 do f(i, g(h()), line!, column!); end\n"
+		"\tfor let j: int = 0, 1 do end\n"
+		"\treturn f;\n"
+		"end\n";
+
+	std::string outcome(const token_buffer& tokens, interner& symbols, bool generated, ast& tree)
+	{
+		parser parser(tokens, symbols);
+
+		try {
+			tree = generated ? parser.parse_generated() : parser.parse();
+			return "parsed";
+		} catch (const lexical_error& error) {
+			return "lexical error: " + std::string(error.what()) + " at " + std::to_string(error.line()) + ':' + std::to_string(error.column());
+		} catch (const parser_error& error) { // where an optional part may be empty the tables take it, then miss what follows
+			return "syntax error at " + std::to_string(error.line()) + ':' + std::to_string(error.column());
+		}
+	}
+
+	int failures = 0;
+
+	void expect(bool condition, const std::string& what)
+	{
+		if (!condition) {
+			std::cerr << "test_generated: " << what << '\n';
+			++failures;
+		}
+	}
+
+	bool conforms(const std::string& name, const std::string& source) // the same tree, or the same first error
+	{
+		interner symbols;
+		stream_info stream(source);
+		std::vector<lexical_diagnostic> diagnostics; // the parsers stop at the tokens in error
+		token_buffer tokens = tokenize(stream, symbols, diagnostics);
+		ast handTree;
+		ast generatedTree;
+		std::string hand = outcome(tokens, symbols, false, handTree);
+		std::string generated = outcome(tokens, symbols, true, generatedTree);
+
+		expect(hand == generated, name + ": hand-written '" + hand + "', generated '" + generated + "'");
+
+		if (hand == "parsed" && generated == "parsed")
+			expect(support::same_tree(handTree, generatedTree), name + ": the trees differ");
+
+		return hand == "parsed";
+	}
+}
+
+// parse_generated and the hand-written parser build the same tree from the same tokens, and stop at the same
+// token when there is an error: on the sample programs, on every rule, and on that with a token dropped. The
+// messages may differ, the generated parser names the token after an empty optional part where the other
+// names the part.
+int main()
+{
+	for (const char* path : { "test/example1.cnt", "test/example2.cnt", "test/lexical_units.cnt", "test/test.cnt" })
+		conforms(path, support::read_file(path));
+
+	conforms("generated", support::program(1 << 16));
+	expect(conforms("coverage", coverage), "the coverage program does not parse");
+
+	// drop one token at random, most of these no longer parse
+	interner symbols;
+	std::string source = coverage;
+	stream_info stream(source);
+	token_buffer tokens = tokenize(stream, symbols);
+	std::mt19937 random(21);
+	std::size_t broken = 0;
+
+	for (int step = 0; step < 300 && failures == 0; ++step) {
+		std::uint32_t index = random() % (tokens.size() - 1);
+		std::string edited = source;
+
+		edited.erase(tokens.offset(index), tokens.length(index));
+		broken += !conforms("without token " + std::to_string(index), edited);
+	}
+
+	expect(broken >= 200, "too few dropped tokens break the program");
+
+	return failures == 0 ? 0 : 1;
+}
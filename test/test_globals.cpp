@@ -0,0 +1,141 @@
+#include <iostream>
+#include <memory>
+#include "analyzer.hpp"
+#include "constant_folder.hpp"
+#include "evaluator.hpp"
+#include "parser.hpp"
+#include "support.hpp"
+
+using namespace cntlang;
+
+namespace
+{
+	struct compiled
+	{
+		std::string source;
+		interner symbols;
+		type_table types;
+		token_buffer tokens;
+		std::unique_ptr<parser> syntax;
+		std::unique_ptr<analyzer> semantics;
+		std::unique_ptr<constant_folder> constants;
+		globals_image image;
+
+		explicit compiled(std::string text)
+		: source(std::move(text))
+		{
+			stream_info stream(source);
+
+			tokens = tokenize(stream, symbols);
+			syntax = std::make_unique<parser>(tokens, symbols);
+			syntax->parse();
+			semantics = std::make_unique<analyzer>(*syntax, types);
+			semantics->analyze();
+			constants = std::make_unique<constant_folder>(syntax->tree(), tokens, *semantics);
+			constants->fold();
+			image = evaluator(syntax->tree(), tokens, *semantics, types, *constants).evaluate();
+		}
+
+		std::string precomputed() const // names and values of the globals in the image, then those pending
+		{
+			std::string names;
+
+			for (std::size_t index = 0; index < image.declarations.size(); ++index) {
+				std::uint32_t token = syntax->tree().token(image.declarations[index]);
+
+				names += source.substr(tokens.offset(token), tokens.length(token)) + '=' + std::to_string(image.values[index].value.integer) + ' ';
+			}
+
+			names += '|';
+
+			for (std::uint32_t definition : image.pending) {
+				std::uint32_t token = syntax->tree().token(syntax->tree().child(definition, 0));
+
+				names += ' ' + source.substr(tokens.offset(token), tokens.length(token));
+			}
+
+			return names;
+		}
+
+		std::uint32_t use(const std::string& name, std::size_t after) const // the first primary_expression naming it past that offset
+		{
+			const ast& tree = syntax->tree();
+
+			for (std::uint32_t index = 1; index < tree.size(); ++index) {
+				std::uint32_t token = tree.token(index);
+
+				if (tree[index].type == node::kind::primary_expression && tokens.offset(token) >= after
+					&& source.compare(tokens.offset(token), tokens.length(token), name) == 0)
+					return index;
+			}
+
+			return ast::dummy;
+		}
+	};
+
+	int failures = 0;
+
+	void expect(bool condition, const std::string& what)
+	{
+		if (!condition) {
+			std::cerr << "test_globals: " << what << '\n';
+			++failures;
+		}
+	}
+}
+
+// A function body may run while a global initializer calls it, before the globals after that initializer are
+// set: neither folding nor evaluation may take their values into the body.
+int main()
+{
+	{
+		compiled program("fn f(): int return g; end\nlet a: int = f();\nlet g: int = 5;\n");
+		std::uint32_t g = program.use("g", 0);
+
+		expect(g != ast::dummy, "g is not named in f");
+		expect(!program.constants->is_constant(g), "g is folded into f, which a runs before g is set");
+		expect(program.precomputed() == "g=5 | a", "a is evaluated with g before g is set: " + program.precomputed());
+	}
+
+	{
+		compiled program("let k: int = 2;\nfn f(): int return k + g; end\nlet a: int = f();\nlet g: int = 5;\n");
+		std::uint32_t k = program.use("k", program.source.find("fn"));
+		std::uint32_t g = program.use("g", program.source.find("fn"));
+
+		expect(k != ast::dummy && program.constants->is_constant(k) && program.constants->value(k).value.integer == 2,
+			"k, set before any initializer calls f, is not folded into f");
+		expect(g != ast::dummy && !program.constants->is_constant(g), "g is folded into f, which a runs before g is set");
+	}
+
+	{
+		compiled program("fn f(): int return g; end\nlet g: int = 5;\nlet a: int = f();\n");
+		std::uint32_t g = program.use("g", 0);
+
+		expect(g != ast::dummy && program.constants->is_constant(g), "g, set before any initializer calls f, is not folded into f");
+		expect(program.precomputed() == "g=5 a=5 |", "a is not evaluated with g set: " + program.precomputed());
+	}
+
+	{
+		// whether the right side of and and or runs is not pinned down, it may only be left out when it cannot matter
+		compiled program("fn f(x: int): bool\n\tlet y: mut int = x;\n\treturn (y += 1) > x;\nend\n"
+			"let a: bool = false and f(1);\nlet b: bool = true or f(2);\nlet c: bool = f(3) and 1 < 2;\nlet d: bool = true or 1 < 2;\n");
+
+		expect(program.precomputed() == "c=1 d=1 | a b", "and and or are evaluated over a right side that calls: " + program.precomputed());
+	}
+
+	{
+		// the evaluator shares these operations; the analyzer rejects real %, evaluate must not divide instead
+		constant x{ type_table::real, {} };
+		constant y{ type_table::real, {} };
+		constant result{ type_table::none, {} };
+
+		x.value.real = 7.5;
+		y.value.real = 2.0;
+
+		expect(constant_folder::evaluate(token::kind::divide, x, y, result) && result.value.real == 3.75, "7.5 / 2.0 is not 3.75");
+		expect(!constant_folder::evaluate(token::kind::remainder, x, y, result), "7.5 % 2.0 is evaluated");
+		expect(!constant_folder::evaluate(token::kind::assign, x, y, result), "7.5 = 2.0 is evaluated");
+	}
+
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,171 @@
+#include <iostream>
+#include "analyzer.hpp"
+#include "constant_folder.hpp"
+#include "evaluator.hpp"
+#include "parser.hpp"
+#include "support.hpp"
+
+using namespace cntlang;
+
+namespace
+{
+	struct compiled
+	{
+		ast tree;
+		std::string error; // the first one thrown, where it was
+		std::uint32_t folded = 0;
+		std::vector<std::uint32_t> precomputed; // tokens of the globals in the image; node indices differ
+		std::vector<std::uint32_t> pending;
+		std::vector<parser_diagnostic> diagnostics; // recovering from every syntax error
+		std::uint32_t unreached = 0; // bodies still lazy after evaluation
+	};
+
+	compiled compile(const std::string& source, bool lazy)
+	{
+		compiled result;
+		interner symbols;
+		type_table types;
+		stream_info stream(source);
+		std::vector<lexical_diagnostic> lexical; // the parsers stop at the tokens in error
+		token_buffer tokens = tokenize(stream, symbols, lexical);
+
+		{
+			parser recovering(tokens, symbols);
+
+			recovering.parse(result.diagnostics, lazy);
+
+			if (lazy)
+				recovering.parse_bodies(result.diagnostics);
+		}
+
+		try {
+			parser parser(tokens, symbols);
+
+			parser.parse(lazy);
+
+			analyzer analyzer(parser, types); // parses the lazy bodies it reaches
+
+			analyzer.analyze();
+
+			constant_folder constants(parser.tree(), tokens, analyzer);
+
+			result.folded = constants.fold();
+
+			globals_image image = evaluator(parser.tree(), tokens, analyzer, types, constants).evaluate();
+
+			for (std::uint32_t declaration : image.declarations)
+				result.precomputed.push_back(parser.tree().token(declaration));
+
+			for (std::uint32_t definition : image.pending)
+				result.pending.push_back(parser.tree().token(definition));
+
+			for (std::uint32_t nth = 0; nth < parser.tree()[parser.tree().root()].count; ++nth) {
+				std::uint32_t definition = parser.tree().child(parser.tree().root(), nth);
+
+				result.unreached += parser.tree()[definition].type == node::kind::function_definition
+					&& parser.tree()[parser.tree().child(definition, 2)].type == node::kind::lazy_body;
+			}
+
+			try {
+				parser.parse_bodies(); // the rest, to compare with the eager tree
+				result.tree = parser.tree();
+			} catch (const parser_error&) { // in a body nothing reached, the eager parse throws it
+			}
+		} catch (const lexical_error& error) {
+			result.error = std::string(error.what()) + " at " + std::to_string(error.line()) + ':' + std::to_string(error.column());
+		} catch (const parser_error& error) {
+			result.error = std::string(error.what()) + " at " + std::to_string(error.line()) + ':' + std::to_string(error.column());
+		} catch (const semantic_error& error) {
+			result.error = std::string(error.what()) + " at " + std::to_string(error.line()) + ':' + std::to_string(error.column());
+		}
+
+		return result;
+	}
+
+	int failures = 0;
+
+	void expect(bool condition, const std::string& what)
+	{
+		if (!condition) {
+			std::cerr << "test_lazy: " << what << '\n';
+			++failures;
+		}
+	}
+}
+
+// A lazy parse checks, folds and evaluates the bodies reached from the globals like an eager parse, and leaves
+// the others lazy and unchecked; once parsed, every body is the one an eager parse builds, and parse_bodies
+// reports the same syntax errors.
+int main()
+{
+	std::vector<std::pair<std::string, std::string>> sources = {
+		{ "generated", support::program(1 << 16) },
+		{ "calls",
+			"let n: int = 10;\n"
+			"fn square(x: int): int\n\treturn x * x;\nend\n"
+			"let s: int = square(n) + 1;\n"
+			"fn total(k: int): int\n\tlet t: mut int = 0;\n\tfor let i: mut int = 0, k do\n\t\tif i % 2 == 0 then t += i; end\n\tend\n\treturn t;\nend\n"
+			"let u: int = total(s) - 2 * 3;\n"
+			"let r: real = u / 4.0;\n" },
+		{ "unclosed body", "fn f(): int\n\treturn 1;\nfn g(): int return 2; end\n" }
+	};
+
+	for (const char* path : { "test/example1.cnt", "test/example2.cnt", "test/lexical_units.cnt", "test/test.cnt" })
+		sources.emplace_back(path, support::read_file(path));
+
+	for (const auto& [name, source] : sources) {
+		compiled eager = compile(source, false);
+		compiled lazy = compile(source, true);
+
+		expect(lazy.diagnostics.size() == eager.diagnostics.size() && std::equal(lazy.diagnostics.begin(), lazy.diagnostics.end(), eager.diagnostics.begin(),
+			[](const parser_diagnostic& left, const parser_diagnostic& right) { return left.error == right.error && left.offset == right.offset; }),
+			name + ": the syntax errors differ");
+
+		if (eager.error.empty()) { // then no reached body has one either
+			expect(lazy.error.empty(), name + ": lazily '" + lazy.error + "'");
+			expect(support::same_tree(lazy.tree, eager.tree), name + ": the trees differ");
+			expect(lazy.precomputed == eager.precomputed && lazy.pending == eager.pending, name + ": evaluation differs");
+			expect(lazy.unreached == 0 ? lazy.folded == eager.folded : lazy.folded <= eager.folded, name + ": folding differs");
+		}
+	}
+
+	// what is only wrong in a body no global reaches is not found, what is in one that is, is
+	const std::pair<const char*, const char*> reached[] = {
+		{ "fn f(): int\n\treturn true;\nend\nfn g(): int return 1 + ; end\nlet x: int = 1;\n", "" },
+		{ "fn f(): int\n\treturn true;\nend\nlet x: int = f();\n", "incompatible types at 2:9" },
+		{ "fn f(): int return 1 + ; end\nlet x: int = f();\n", "expected expression at 1:24" },
+		{ "fn f(): int\n\treturn true;\nend\nlet c: int() = f;\n", "incompatible types at 2:9" },
+		{ "fn h(): int\n\treturn true;\nend\nfn u(): int return 1 + ; end\nfn g(): int return h(); end\nlet x: int = g();\n", "incompatible types at 2:9" }
+	};
+
+	for (const auto& [source, error] : reached) {
+		compiled lazy = compile(source, true);
+
+		expect(lazy.error == error, std::string(source) + ": lazily '" + lazy.error + "', expected '" + error + "'");
+	}
+
+	{
+		// recovering, as --lint does: the syntax errors of the bodies reached, whichever order they are reached in
+		std::string source = "fn f(): int return 1 + ; end\nfn g(): int return 2 + ; end\nfn h(): int return 3 + ; end\n"
+			"fn k(): int\n\treturn true;\nend\nlet x: int = h() + f() + k();\n";
+		interner symbols;
+		type_table types;
+		stream_info stream(source);
+		token_buffer tokens = tokenize(stream, symbols);
+		parser parser(tokens, symbols);
+		std::vector<parser_diagnostic> syntax;
+		std::vector<semantic_diagnostic> semantic;
+
+		parser.parse(true);
+		analyzer(parser, types).analyze(syntax, semantic);
+
+		expect(syntax.size() == 2 && tokens.lines().locate(syntax[0].offset).line == 1 && tokens.lines().locate(syntax[1].offset).line == 3,
+			"the syntax errors of the reached bodies are not recorded in source order");
+		expect(semantic.size() == 1 && tokens.lines().locate(semantic[0].offset).line == 5, "the type error of a reached body is not recorded");
+	}
+
+	expect(compile(reached[0].first, true).unreached == 2, "bodies no global reaches are parsed");
+	expect(compile(sources[1].second, true).unreached == 0, "bodies the globals call are not parsed");
+
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,153 @@
+#include <iostream>
+#include <random>
+#include "parser.hpp"
+#include "support.hpp"
+
+using namespace cntlang;
+
+namespace
+{
+	struct lexed
+	{
+		token_buffer tokens;
+		std::vector<lexical_diagnostic> diagnostics;
+	};
+
+	lexed lex(const std::string& source, interner& symbols)
+	{
+		lexed result;
+		stream_info stream(source);
+
+		result.tokens = tokenize(stream, symbols, result.diagnostics);
+		return result;
+	}
+
+	std::string outcome(parser& editor, const token_change& change) // of reparse, the tree is checked apart
+	{
+		try {
+			editor.reparse(change);
+			return "parsed";
+		} catch (const lexical_error& error) {
+			return "lexical error: " + std::string(error.what()) + " at " + std::to_string(error.line()) + ':' + std::to_string(error.column());
+		} catch (const parser_error& error) {
+			return std::string(error.what()) + " at " + std::to_string(error.line()) + ':' + std::to_string(error.column());
+		}
+	}
+
+	std::string outcome(parser& fresh)
+	{
+		try {
+			fresh.parse();
+			return "parsed";
+		} catch (const lexical_error& error) {
+			return "lexical error: " + std::string(error.what()) + " at " + std::to_string(error.line()) + ':' + std::to_string(error.column());
+		} catch (const parser_error& error) {
+			return std::string(error.what()) + " at " + std::to_string(error.line()) + ':' + std::to_string(error.column());
+		}
+	}
+
+	int failures = 0;
+
+	void expect(bool condition, const std::string& what)
+	{
+		if (!condition) {
+			std::cerr << "test_relex: " << what << '\n';
+			++failures;
+		}
+	}
+}
+
+// relex keeps the buffer in step with the source through edits that do not lex, and reparse follows it.
+int main()
+{
+	std::string source = support::program(1 << 16);
+	interner symbols;
+	token_buffer tokens = lex(source, symbols).tokens;
+	parser editor(tokens, symbols);
+	std::vector<lexical_diagnostic> diagnostics;
+
+	editor.parse();
+
+	// typing an exponent: "10" becomes "1e", which does not lex, then "1e4", which does
+	std::size_t offset = source.find("0, 10 do") + 3;
+
+	source.replace(offset, 2, "1e");
+
+	token_change change = relex(tokens, source, { offset, 2, 2 }, symbols, diagnostics);
+	lexed expected = lex(source, symbols);
+
+	expect(diagnostics.size() == 1 && diagnostics[0].error == lexical_error::kind::expected_exponent, "1e is not reported");
+	expect(expected.diagnostics.size() == 1 && diagnostics[0].offset == expected.diagnostics[0].offset, "1e is reported elsewhere than by tokenize");
+	expect(support::same_tokens(tokens, expected.tokens), "tokens differ from tokenize after 1e");
+	expect(outcome(editor, change).find("lexical error: expected exponent") == 0, "reparse does not stop at 1e");
+
+	source.insert(offset + 2, "4");
+	diagnostics.clear();
+	change = relex(tokens, source, { offset + 2, 0, 1 }, symbols, diagnostics);
+	expected = lex(source, symbols);
+
+	expect(diagnostics.empty(), "1e4 is reported");
+	expect(support::same_tokens(tokens, expected.tokens), "tokens differ from tokenize after 1e4");
+	expect(outcome(editor, change) == "parsed", "reparse fails after 1e4");
+
+	{
+		parser fresh(tokens, symbols);
+		expect(support::same_tree(editor.tree(), fresh.parse()), "reparse differs from a full parse after 1e4");
+	}
+
+	// random edits, lexically broken ones among them, each undone by the next
+	const char* fragments[] = { "1e", "1e+", "!", "foo!", "@", "4", "x", " ", "\n", "# note\n", "end", ";", "let", "(", ")",
+		"1.5", "y + 1", "\tlet z: int = 3;\n", "\tgi += 1;\n", "" };
+	std::mt19937 random(7);
+	std::size_t parsed = 0;
+	std::size_t unlexed = 0;
+
+	for (int step = 0; step < 600 && failures == 0; ++step) {
+		static std::size_t at;
+		static std::string removed;
+		static std::string inserted;
+
+		if (step % 2 == 0) {
+			at = random() % (source.size() + 1);
+			removed = source.substr(at, random() % 6);
+			inserted = fragments[random() % (sizeof(fragments) / sizeof(*fragments))];
+		} else {
+			std::swap(removed, inserted);
+		}
+
+		source.replace(at, removed.size(), inserted);
+		diagnostics.clear();
+		change = relex(tokens, source, { at, removed.size(), inserted.size() }, symbols, diagnostics);
+		expected = lex(source, symbols);
+
+		std::string where = "step " + std::to_string(step) + ": ";
+		bool reported = true;
+
+		for (const lexical_diagnostic& diagnostic : diagnostics) {
+			reported = reported && std::find_if(expected.diagnostics.begin(), expected.diagnostics.end(), [&diagnostic](const lexical_diagnostic& other) {
+				return other.error == diagnostic.error && other.offset == diagnostic.offset;
+			}) != expected.diagnostics.end();
+		}
+
+		expect(reported, where + "an error is reported that tokenize does not report");
+		expect(support::same_tokens(tokens, expected.tokens), where + "tokens differ from tokenize");
+
+		parser fresh(tokens, symbols);
+		std::string incremental = outcome(editor, change);
+		std::string full = outcome(fresh);
+
+		expect(incremental == full, where + "reparse gives '" + incremental + "', a full parse '" + full + "'");
+
+		if (full.find("lexical error") == 0)
+			++unlexed;
+
+		if (incremental == "parsed" && full == "parsed") {
+			expect(support::same_tree(editor.tree(), fresh.tree()), where + "reparse differs from a full parse");
+			++parsed;
+		}
+	}
+
+	expect(parsed >= 300 && unlexed >= 30, "too few edits parse, or too few do not lex");
+
+	return failures == 0 ? 0 : 1;
+}
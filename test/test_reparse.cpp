@@ -0,0 +1,125 @@
+#include <iostream>
+#include <random>
+#include "parser.hpp"
+#include "support.hpp"
+
+using namespace cntlang;
+
+namespace
+{
+	std::string outcome(parser& editor, const token_change& change)
+	{
+		try {
+			editor.reparse(change);
+			return "parsed";
+		} catch (const parser_error& error) {
+			return std::string(error.what()) + " at " + std::to_string(error.line()) + ':' + std::to_string(error.column());
+		}
+	}
+
+	std::string outcome(parser& fresh)
+	{
+		try {
+			fresh.parse();
+			return "parsed";
+		} catch (const parser_error& error) {
+			return std::string(error.what()) + " at " + std::to_string(error.line()) + ':' + std::to_string(error.column());
+		}
+	}
+
+	int failures = 0;
+
+	void expect(bool condition, const std::string& what)
+	{
+		if (!condition) {
+			std::cerr << "test_reparse: " << what << '\n';
+			++failures;
+		}
+	}
+}
+
+// Reparsing after each edit builds the tree a full parse builds, and the nodes it orphans are reclaimed: over
+// many edits the tree stays within a small factor of a freshly parsed one.
+int main()
+{
+	std::string source = support::program(1 << 14);
+	interner symbols;
+	std::vector<lexical_diagnostic> diagnostics;
+	stream_info stream(source);
+	token_buffer tokens = tokenize(stream, symbols);
+	parser editor(tokens, symbols);
+
+	editor.parse();
+
+	// edits inside a statement list, inside a definition and across definitions, each undone by the next
+	struct pattern
+	{
+		const char* find;
+		std::size_t skip; // into the match
+		std::size_t removed;
+		const char* inserted;
+	};
+
+	const pattern patterns[] = {
+		{ "0, 10 do", 3, 2, "25" }, // a literal in a for header
+		{ "\tgi += 1;\n", 0, 0, "\tgi += 2;\n" }, // a statement
+		{ "s / 2", 4, 1, "(3 + gi)" }, // an expression
+		{ "\twhile", 0, 0, "\tlet w: int = 4;\n" }, // a local
+		{ "elseif k > 7 then break; ", 0, 25, "" }, // a branch
+		{ ": real\n", 2, 4, "int" }, // a function header, the tree may be parsed again from scratch
+		{ "fn f", 0, 0, "let q: int = 1;\n" }, // a definition, likewise
+		{ "return h", 6, 0, " (" } // a syntax error, so is the tree after it
+	};
+	const std::size_t in_place = 5; // the patterns before these three are reparsed within one statement list
+
+	std::mt19937 random(19);
+	std::size_t parsed = 0;
+
+	for (int step = 0; step < 1000 && failures == 0; ++step) {
+		static std::size_t at;
+		static std::string removed;
+		static std::string inserted;
+
+		if (step % 2 == 0) {
+			// only edits reparsed in place at first, so what they orphan piles up unless it is reclaimed
+			const pattern& edit = patterns[random() % (step < 600 ? in_place : sizeof(patterns) / sizeof(*patterns))];
+			std::size_t matches = 0;
+
+			for (std::size_t found = source.find(edit.find); found != std::string::npos; found = source.find(edit.find, found + 1))
+				++matches;
+
+			at = source.find(edit.find);
+
+			for (std::size_t nth = random() % matches; nth > 0; --nth)
+				at = source.find(edit.find, at + 1);
+
+			at += edit.skip;
+			removed = source.substr(at, edit.removed);
+			inserted = edit.inserted;
+		} else {
+			std::swap(removed, inserted);
+		}
+
+		source.replace(at, removed.size(), inserted);
+		diagnostics.clear();
+
+		token_change change = relex(tokens, source, { at, removed.size(), inserted.size() }, symbols, diagnostics);
+		parser fresh(tokens, symbols);
+		std::string incremental = outcome(editor, change);
+		std::string full = outcome(fresh);
+		std::string where = "step " + std::to_string(step) + ": ";
+
+		expect(incremental == full, where + "reparse gives '" + incremental + "', a full parse '" + full + "'");
+
+		if (incremental == "parsed" && full == "parsed") {
+			expect(support::same_tree(editor.tree(), fresh.tree()), where + "reparse differs from a full parse");
+			expect(editor.tree().size() <= 3 * fresh.tree().size(), where + std::to_string(editor.tree().size()) + " nodes after reparse, "
+				+ std::to_string(fresh.tree().size()) + " after a full parse");
+			++parsed;
+		}
+	}
+
+	expect(parsed >= 800, "too few edits parse");
+
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,551 @@
+// Turns doc/parser_rules.ebnf into the LL(1) prediction table parser::parse_generated walks.
+//
+// Lowercase rules open a frame in the parser so it can build their node, UPPERCASE rules are expanded in
+// place, and names no rule defines are terminals, spelled as token::kind enumerators. Repetitions, options
+// and groups become helper rules. A conflict between an empty and a non-empty alternative is resolved in
+// favour of the non-empty one, the longest match the hand-written parser takes as well; any other conflict
+// fails the build.
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace cntlang
+{
+	struct ebnf
+	{
+		enum class kind { name, sequence, choice, repetition, option };
+
+		kind type;
+		std::string name;
+		std::vector<ebnf> items;
+	};
+
+	struct ebnf_rule
+	{
+		std::string name;
+		ebnf body;
+	};
+
+	class ebnf_reader
+	{
+	public:
+		explicit ebnf_reader(std::string text)
+		: m_text(std::move(text))
+		{
+		}
+
+		std::vector<ebnf_rule> read()
+		{
+			std::vector<ebnf_rule> rules;
+
+			for (next(); !m_word.empty();) {
+				ebnf_rule rule{ m_word, {} };
+
+				if (!is_name(rule.name))
+					fail("expected a rule name");
+
+				next();
+				expect("=");
+				rule.body = read_choice();
+				expect(";");
+				rules.push_back(std::move(rule));
+			}
+
+			return rules;
+		}
+
+	private:
+		static bool is_name(const std::string& word)
+		{
+			return !word.empty() && (std::isalpha(static_cast<unsigned char>(word[0])) || word[0] == '_');
+		}
+
+		void next()
+		{
+			for (;;) {
+				while (m_at < m_text.size() && std::isspace(static_cast<unsigned char>(m_text[m_at]))) {
+					if (m_text[m_at++] == '\n')
+						++m_line;
+				}
+
+				if (m_text.compare(m_at, 2, "(*") != 0)
+					break;
+
+				std::size_t close = m_text.find("*)", m_at + 2);
+
+				if (close == std::string::npos)
+					fail("unterminated comment");
+
+				m_line += std::count(m_text.begin() + m_at, m_text.begin() + close, '\n');
+				m_at = close + 2;
+			}
+
+			std::size_t start = m_at;
+
+			if (m_at < m_text.size() && (std::isalnum(static_cast<unsigned char>(m_text[m_at])) || m_text[m_at] == '_')) {
+				while (m_at < m_text.size() && (std::isalnum(static_cast<unsigned char>(m_text[m_at])) || m_text[m_at] == '_'))
+					++m_at;
+			} else if (m_at < m_text.size()) {
+				++m_at;
+			}
+
+			m_word = m_text.substr(start, m_at - start);
+		}
+
+		void expect(const char* word)
+		{
+			if (m_word != word)
+				fail(std::string("expected '") + word + "'");
+
+			next();
+		}
+
+		[[noreturn]] void fail(const std::string& message) const
+		{
+			throw std::runtime_error(std::to_string(m_line) + ": " + message + (m_word.empty() ? "" : " at '" + m_word + "'"));
+		}
+
+		ebnf read_choice()
+		{
+			ebnf choice{ ebnf::kind::choice, {}, { read_sequence() } };
+
+			while (m_word == "|") {
+				next();
+				choice.items.push_back(read_sequence());
+			}
+
+			return choice.items.size() == 1 ? std::move(choice.items.front()) : choice;
+		}
+
+		ebnf read_sequence()
+		{
+			ebnf sequence{ ebnf::kind::sequence, {}, {} };
+
+			while (m_word != "|" && m_word != ";" && m_word != ")" && m_word != "]" && m_word != "}") {
+				if (m_word.empty())
+					fail("unexpected end of grammar");
+
+				sequence.items.push_back(read_factor());
+			}
+
+			return sequence.items.size() == 1 ? std::move(sequence.items.front()) : sequence;
+		}
+
+		ebnf read_factor()
+		{
+			if (is_name(m_word)) {
+				ebnf name{ ebnf::kind::name, m_word, {} };
+
+				next();
+				return name;
+			}
+
+			std::string open = m_word;
+			ebnf::kind type = open == "{" ? ebnf::kind::repetition : open == "[" ? ebnf::kind::option : ebnf::kind::choice;
+
+			if (open != "{" && open != "[" && open != "(")
+				fail("unexpected symbol");
+
+			next();
+
+			ebnf inner = read_choice();
+
+			expect(open == "{" ? "}" : open == "[" ? "]" : ")");
+
+			if (type == ebnf::kind::choice)
+				return inner;
+
+			return ebnf{ type, {}, { std::move(inner) } };
+		}
+
+		std::string m_text;
+		std::string m_word;
+		std::size_t m_at = 0;
+		long m_line = 1;
+	};
+
+	struct symbol
+	{
+		bool rule;
+		std::uint32_t index; // into rules or terminals
+	};
+
+	class ll1_grammar
+	{
+	public:
+		explicit ll1_grammar(const std::vector<ebnf_rule>& rules)
+		{
+			for (const auto& rule : rules) { // frames first, so a single bound tells them apart
+				if (std::islower(static_cast<unsigned char>(rule.name[0])))
+					add_rule(rule.name, 0);
+			}
+
+			m_frames = m_rules.size();
+
+			for (const auto& rule : rules) {
+				if (!std::islower(static_cast<unsigned char>(rule.name[0])))
+					add_rule(rule.name, 0);
+			}
+
+			m_named = m_rules.size();
+
+			for (std::uint32_t index = 0; index < m_named; ++index)
+				m_owners[index] = index;
+
+			for (const auto& rule : rules) {
+				std::uint32_t lhs = find_rule(rule.name);
+
+				for (const auto& alternative : alternatives(rule.body))
+					add_production(lhs, lower(alternative, lhs));
+			}
+
+			analyze();
+			build_table();
+		}
+
+		void write(std::ostream& out, const std::string& source) const
+		{
+			out << "// Generated by tools/ll1_tables from " << source << ", edit the grammar instead.\n"
+				<< "#pragma once\n\n"
+				<< "#include <algorithm>\n#include <array>\n#include <cstddef>\n#include <cstdint>\n#include \"token.hpp\"\n\n"
+				<< "namespace cntlang\n{\n\tnamespace grammar\n\t{\n"
+				<< "\t\tenum class rule : std::uint8_t\n\t\t{\n";
+
+			for (std::size_t index = 0; index < m_rules.size(); ++index)
+				out << "\t\t\t" << m_rules[index] << (index + 1 < m_rules.size() ? ",\n" : "\n");
+
+			out << "\t\t};\n\n"
+				<< "\t\tconstexpr std::size_t rule_count = " << m_rules.size() << ";\n"
+				<< "\t\tconstexpr std::size_t frame_rules = " << m_frames << "; // rules below open a frame\n"
+				<< "\t\tconstexpr std::uint16_t rule_symbol = 0x100; // production symbols below are token kinds\n"
+				<< "\t\tconstexpr std::uint8_t no_production = 0xff;\n\n"
+				<< "\t\tconstexpr std::size_t token_count = std::max({\n";
+
+			for (std::size_t index = 0; index < m_terminals.size(); ++index)
+				out << "\t\t\tstatic_cast<std::size_t>(token::kind::" << m_terminals[index] << ")" << (index + 1 < m_terminals.size() ? ",\n" : "\n");
+
+			out << "\t\t}) + 1;\n\n"
+				<< "\t\tconstexpr rule owners[] = { // named rule a helper was made for\n";
+
+			for (std::uint32_t owner : m_owners)
+				out << "\t\t\trule::" << m_rules[owner] << ",\n";
+
+			out << "\t\t};\n\n\t\tconstexpr std::uint16_t symbols[] = {\n";
+
+			for (const auto& production : m_productions) {
+				out << "\t\t\t";
+
+				for (const symbol& item : production) {
+					if (item.rule)
+						out << "rule_symbol + static_cast<std::uint16_t>(rule::" << m_rules[item.index] << "), ";
+					else
+						out << "static_cast<std::uint16_t>(token::kind::" << m_terminals[item.index] << "), ";
+				}
+
+				out << "// " << m_rules[m_lhs[&production - m_productions.data()]] << "\n";
+			}
+
+			out << "\t\t};\n\n"
+				<< "\t\tstruct production\n\t\t{\n\t\t\tstd::uint16_t first; // into symbols\n\t\t\tstd::uint16_t count;\n\t\t};\n\n"
+				<< "\t\tconstexpr production productions[] = {\n";
+
+			for (std::size_t index = 0, first = 0; index < m_productions.size(); first += m_productions[index++].size())
+				out << "\t\t\t{ " << first << ", " << m_productions[index].size() << " },\n";
+
+			out << "\t\t};\n\n"
+				<< "\t\tstruct prediction\n\t\t{\n\t\t\trule lhs;\n\t\t\ttoken::kind next;\n\t\t\tstd::uint8_t production;\n\t\t};\n\n"
+				<< "\t\tconstexpr prediction predictions[] = {\n";
+
+			for (std::size_t lhs = 0; lhs < m_rules.size(); ++lhs) {
+				for (std::size_t next = 0; next < m_terminals.size(); ++next) {
+					if (m_table[lhs][next] >= 0 && m_table[lhs][next] != m_defaults[lhs])
+						out << "\t\t\t{ rule::" << m_rules[lhs] << ", token::kind::" << m_terminals[next] << ", " << m_table[lhs][next] << " },\n";
+				}
+			}
+
+			out << "\t\t};\n\n"
+				<< "\t\tconstexpr std::uint8_t defaults[] = { // taken on any other token, the empty alternative of a rule\n\t\t\t";
+
+			for (int production : m_defaults)
+				out << (production < 0 ? std::string("no_production") : std::to_string(production)) << ", ";
+
+			out << "\n\t\t};\n\n"
+				<< "\t\tconstexpr auto make_table()\n\t\t{\n"
+				<< "\t\t\tstd::array<std::array<std::uint8_t, token_count>, rule_count> table{};\n\n"
+				<< "\t\t\tfor (std::size_t lhs = 0; lhs < rule_count; ++lhs) {\n"
+				<< "\t\t\t\tfor (auto& cell : table[lhs])\n\t\t\t\t\tcell = defaults[lhs];\n\t\t\t}\n\n"
+				<< "\t\t\tfor (const auto& entry : predictions)\n"
+				<< "\t\t\t\ttable[static_cast<std::size_t>(entry.lhs)][static_cast<std::size_t>(entry.next)] = entry.production;\n\n"
+				<< "\t\t\treturn table;\n\t\t}\n\n"
+				<< "\t\tconstexpr auto table = make_table(); // production of a rule by the next token\n"
+				<< "\t}\n}\n";
+		}
+
+	private:
+		std::uint32_t add_rule(const std::string& name, std::uint32_t owner)
+		{
+			m_rules.push_back(name);
+			m_owners.push_back(owner);
+			return static_cast<std::uint32_t>(m_rules.size() - 1);
+		}
+
+		std::uint32_t find_rule(const std::string& name) const
+		{
+			auto found = std::find(m_rules.begin(), m_rules.begin() + m_named, name);
+
+			return found == m_rules.begin() + m_named ? ~std::uint32_t(0) : static_cast<std::uint32_t>(found - m_rules.begin());
+		}
+
+		std::uint32_t find_terminal(const std::string& name)
+		{
+			if (!std::islower(static_cast<unsigned char>(name[0])))
+				throw std::runtime_error("undefined rule " + name);
+
+			auto found = std::find(m_terminals.begin(), m_terminals.end(), name);
+
+			if (found != m_terminals.end())
+				return static_cast<std::uint32_t>(found - m_terminals.begin());
+
+			m_terminals.push_back(name);
+			return static_cast<std::uint32_t>(m_terminals.size() - 1);
+		}
+
+		void add_production(std::uint32_t lhs, std::vector<symbol> items)
+		{
+			m_lhs.push_back(lhs);
+			m_productions.push_back(std::move(items));
+		}
+
+		static std::vector<ebnf> alternatives(const ebnf& body)
+		{
+			return body.type == ebnf::kind::choice ? body.items : std::vector<ebnf>{ body };
+		}
+
+		std::uint32_t helper(std::uint32_t owner)
+		{
+			std::uint32_t count = 1;
+
+			for (std::uint32_t existing : m_owners)
+				count += existing == owner;
+
+			return add_rule(m_rules[owner] + "_" + std::to_string(count - 1), owner);
+		}
+
+		std::vector<symbol> lower(const ebnf& item, std::uint32_t owner)
+		{
+			std::vector<symbol> items;
+
+			switch (item.type) {
+			case ebnf::kind::name: {
+				std::uint32_t rule = find_rule(item.name);
+
+				items.push_back(rule != ~std::uint32_t(0) ? symbol{ true, rule } : symbol{ false, find_terminal(item.name) });
+				break;
+			}
+			case ebnf::kind::sequence:
+				for (const auto& part : item.items) {
+					std::vector<symbol> lowered = lower(part, owner);
+
+					items.insert(items.end(), lowered.begin(), lowered.end());
+				}
+				break;
+			case ebnf::kind::choice:
+			case ebnf::kind::repetition:
+			case ebnf::kind::option: {
+				std::uint32_t rule = helper(owner);
+
+				for (const auto& alternative : alternatives(item.type == ebnf::kind::choice ? item : item.items.front())) {
+					std::vector<symbol> lowered = lower(alternative, owner);
+
+					if (item.type == ebnf::kind::repetition)
+						lowered.push_back({ true, rule });
+
+					add_production(rule, std::move(lowered));
+				}
+
+				if (item.type != ebnf::kind::choice)
+					add_production(rule, {});
+
+				items.push_back({ true, rule });
+				break;
+			}
+			}
+
+			return items;
+		}
+
+		bool nullable(const std::vector<symbol>& items, std::size_t from = 0) const
+		{
+			for (std::size_t index = from; index < items.size(); ++index) {
+				if (!items[index].rule || !m_nullable[items[index].index])
+					return false;
+			}
+
+			return true;
+		}
+
+		std::set<std::uint32_t> first(const std::vector<symbol>& items, std::size_t from = 0) const
+		{
+			std::set<std::uint32_t> terminals;
+
+			for (std::size_t index = from; index < items.size(); ++index) {
+				if (!items[index].rule) {
+					terminals.insert(items[index].index);
+					break;
+				}
+
+				terminals.insert(m_first[items[index].index].begin(), m_first[items[index].index].end());
+
+				if (!m_nullable[items[index].index])
+					break;
+			}
+
+			return terminals;
+		}
+
+		void analyze()
+		{
+			m_nullable.assign(m_rules.size(), false);
+			m_first.assign(m_rules.size(), {});
+			m_follow.assign(m_rules.size(), {});
+
+			for (bool changed = true; changed;) {
+				changed = false;
+
+				for (std::size_t index = 0; index < m_productions.size(); ++index) {
+					std::uint32_t lhs = m_lhs[index];
+					std::set<std::uint32_t> terminals = first(m_productions[index]);
+					std::size_t before = m_first[lhs].size();
+
+					m_first[lhs].insert(terminals.begin(), terminals.end());
+					changed |= m_first[lhs].size() != before;
+
+					if (!m_nullable[lhs] && nullable(m_productions[index]))
+						changed = m_nullable[lhs] = true;
+				}
+			}
+
+			for (bool changed = true; changed;) {
+				changed = false;
+
+				for (std::size_t index = 0; index < m_productions.size(); ++index) {
+					const auto& items = m_productions[index];
+
+					for (std::size_t at = 0; at < items.size(); ++at) {
+						if (!items[at].rule)
+							continue;
+
+						auto& follow = m_follow[items[at].index];
+						std::size_t before = follow.size();
+						std::set<std::uint32_t> rest = first(items, at + 1);
+
+						follow.insert(rest.begin(), rest.end());
+
+						if (nullable(items, at + 1))
+							follow.insert(m_follow[m_lhs[index]].begin(), m_follow[m_lhs[index]].end());
+
+						changed |= follow.size() != before;
+					}
+				}
+			}
+		}
+
+		void predict(std::uint32_t lhs, std::uint32_t next, int production)
+		{
+			int& cell = m_table[lhs][next];
+
+			if (cell < 0 || cell == production) {
+				cell = production;
+				return;
+			}
+
+			bool emptyBefore = nullable(m_productions[cell]);
+			bool emptyNow = nullable(m_productions[production]);
+
+			if (emptyBefore == emptyNow)
+				throw std::runtime_error("not LL(1): " + m_rules[lhs] + " has two alternatives starting with " + m_terminals[next]);
+
+			if (emptyBefore) // the longer match wins
+				cell = production;
+		}
+
+		void build_table()
+		{
+			if (m_rules.size() > 255 || m_productions.size() >= 255)
+				throw std::runtime_error("grammar too large for 8-bit rule and production indices");
+
+			m_table.assign(m_rules.size(), std::vector<int>(m_terminals.size(), -1));
+			m_defaults.assign(m_rules.size(), -1);
+
+			for (std::size_t index = 0; index < m_productions.size(); ++index) {
+				std::uint32_t lhs = m_lhs[index];
+
+				for (std::uint32_t next : first(m_productions[index]))
+					predict(lhs, next, static_cast<int>(index));
+
+				if (nullable(m_productions[index])) {
+					for (std::uint32_t next : m_follow[lhs])
+						predict(lhs, next, static_cast<int>(index));
+
+					m_defaults[lhs] = static_cast<int>(index); // errors then show at the next terminal
+				}
+			}
+		}
+
+		std::vector<std::string> m_rules; // lowercase named, uppercase named, then helpers
+		std::vector<std::uint32_t> m_owners;
+		std::size_t m_frames = 0;
+		std::size_t m_named = 0;
+		std::vector<std::string> m_terminals;
+		std::vector<std::uint32_t> m_lhs; // per production
+		std::vector<std::vector<symbol>> m_productions;
+		std::vector<bool> m_nullable;
+		std::vector<std::set<std::uint32_t>> m_first;
+		std::vector<std::set<std::uint32_t>> m_follow;
+		std::vector<std::vector<int>> m_table;
+		std::vector<int> m_defaults;
+	};
+}
+
+int main(int argc, char** argv)
+{
+	if (argc != 3) {
+		std::cerr << "usage: ll1_tables grammar.ebnf output.hpp\n";
+		return 1;
+	}
+
+	std::ifstream input(argv[1]);
+
+	if (!input) {
+		std::cerr << "could not open " << argv[1] << "!\n";
+		return 1;
+	}
+
+	std::stringstream text;
+	text << input.rdbuf();
+
+	try {
+		cntlang::ll1_grammar grammar(cntlang::ebnf_reader(text.str()).read());
+		std::ofstream output(argv[2]);
+
+		grammar.write(output, argv[1]);
+
+		if (!output) {
+			std::cerr << "could not write " << argv[2] << "!\n";
+			return 1;
+		}
+	} catch (const std::runtime_error& error) {
+		std::cerr << argv[1] << ':' << error.what() << '\n';
+		return 1;
+	}
+
+	return 0;
+}